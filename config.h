@@ -57,10 +57,17 @@
 #define ALIGNMENT 8  
 
 /* 
- * Maximum heap size in bytes 
+ * Maximum heap size in bytes, unless mdriver -H sets another
  */
 #define MAX_HEAP (200*(1<<20))  /* 200 MB */
 
+/*
+ * Size of the address range mem_map hands out mappings from, and
+ * the granularity of those mappings
+ */
+#define MAX_MAP  (200*(1<<20))  /* 200 MB */
+#define MAP_PAGE 4096
+
 /*****************************************************************************
  * Set exactly one of these USE_xxx constants to "1" to select a timing method
  *****************************************************************************/
@@ -0,0 +1,447 @@
+/*
+ * ctree.c - Address-ordered fit over a Cartesian tree of free blocks.
+ *
+ * Uses the same boundary tag block format as mm.c (4 byte header
+ * and footer holding size | alloc). Free blocks of TREE_MIN bytes
+ * or more form a Cartesian tree (treap): in-order by address, and
+ * heap-ordered by a priority hashed from the address. Each node
+ * also carries the largest block size in its subtree.
+ *
+ * Heap-ordering by block size instead (the classic fast-fit tree)
+ * degenerates into a list whenever sizes grow with address, which
+ * is exactly what the wilderness block does. The hashed priority
+ * keeps the expected depth O(log n), and the subtree maximum still
+ * lets find_fit steer towards the lowest-addressed block that fits.
+ * Insert, remove and lookup are therefore all O(log n) expected,
+ * with address-ordered placement instead of mm.c's LIFO order.
+ *
+ * Free blocks of MINIMUM size cannot hold a node and go in a side
+ * list of their own.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <memory.h>
+#include "mm.h"
+#include "memlib.h"
+
+team_t team = {
+    "The BOI",
+    "Vincent Liu",
+    "vili1624@colorado.edu",
+    "Christian Sousa",
+    "chso8299@colorado.edu"
+};
+
+#define WSIZE       4
+#define DSIZE       8
+#define CHUNKSIZE  (1<<8)
+#define OVERHEAD    8
+#define MINIMUM     24
+#define TREE_MIN    (OVERHEAD + sizeof(tnode))
+
+static inline int MAX(int x, int y)
+{
+    return x > y ? x : y;
+}
+
+static inline uint32_t PACK(uint32_t size, int alloc)
+{
+    return ((size) | (alloc & 0x1));
+}
+
+static inline uint32_t GET(void *p)
+{
+    return  *(uint32_t *)p;
+}
+
+static inline void PUT( void *p, uint32_t val)
+{
+    *((uint32_t *)p) = val;
+}
+
+static inline uint32_t GET_SIZE(void *p)
+{
+    return GET(p) & ~0x7;
+}
+
+static inline int GET_ALLOC(void *p)
+{
+    return GET(p) & 0x1;
+}
+
+static inline void *HDRP(void *bp)
+{
+    return ( (char *)bp) - WSIZE;
+}
+
+static inline void *FTRP(void *bp)
+{
+    return ((char *)(bp) + GET_SIZE(HDRP(bp)) - DSIZE);
+}
+
+static inline void *NEXT_BLKP(void *bp)
+{
+    return  ((char *)(bp) + GET_SIZE(((char *)(bp) - WSIZE)));
+}
+
+static inline void* PREV_BLKP(void *bp)
+{
+    return  ((char *)(bp) - GET_SIZE(((char *)(bp) - DSIZE)));
+}
+
+typedef struct freelist
+{
+    struct freelist *prev;
+    struct freelist *next;
+}freelist;
+
+typedef struct tnode
+{
+    struct tnode *left;
+    struct tnode *right;
+    uint32_t max;
+}tnode;
+
+static tnode *root;
+static freelist *small;
+
+static void *extend_heap(uint32_t words);
+static void insert_to_free(freelist *bp);
+static void remove_from_free(freelist* bp);
+static void *find_fit(uint32_t asize);
+static void place(void *bp, uint32_t asize);
+static void *coalesce(void *bp);
+
+/*
+ * Block addresses are evenly spaced, so a plain multiplicative hash
+ * keeps them in a regular order; mix all the bits (splitmix64).
+ */
+static inline uint32_t PRIO(tnode *n)
+{
+    uint64_t x = (uint64_t)(uintptr_t)n;
+
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return (uint32_t)((x ^ (x >> 31)) >> 32);
+}
+
+static inline uint32_t MAXOF(tnode *n)
+{
+    return n != NULL ? n->max : 0;
+}
+
+static inline void update(tnode *n)
+{
+    uint32_t m = GET_SIZE(HDRP(n));
+
+    if(MAXOF(n->left) > m)
+        m = MAXOF(n->left);
+    if(MAXOF(n->right) > m)
+        m = MAXOF(n->right);
+    n->max = m;
+}
+
+/*
+ * split - cut t into the nodes below key and the nodes above it
+ */
+static void split(tnode *t, tnode *key, tnode **l, tnode **r)
+{
+    if(t == NULL)
+    {
+        *l = NULL;
+        *r = NULL;
+    }
+    else if(t < key)
+    {
+        split(t->right, key, &t->right, r);
+        *l = t;
+        update(t);
+    }
+    else
+    {
+        split(t->left, key, l, &t->left);
+        *r = t;
+        update(t);
+    }
+}
+
+/*
+ * merge - join two trees where every node of a is below every node of b
+ */
+static tnode *merge(tnode *a, tnode *b)
+{
+    if(a == NULL)
+        return b;
+    if(b == NULL)
+        return a;
+    if(PRIO(a) > PRIO(b))
+    {
+        a->right = merge(a->right, b);
+        update(a);
+        return a;
+    }
+    b->left = merge(a, b->left);
+    update(b);
+    return b;
+}
+
+static tnode *tree_insert(tnode *t, tnode *z)
+{
+    if(t == NULL || PRIO(z) > PRIO(t))
+    {
+        split(t, z, &z->left, &z->right);
+        update(z);
+        return z;
+    }
+    if(z < t)
+        t->left = tree_insert(t->left, z);
+    else
+        t->right = tree_insert(t->right, z);
+    update(t);
+    return t;
+}
+
+static tnode *tree_remove(tnode *t, tnode *z)
+{
+    if(t == z)
+        return merge(t->left, t->right);
+    if(z < t)
+        t->left = tree_remove(t->left, z);
+    else
+        t->right = tree_remove(t->right, z);
+    update(t);
+    return t;
+}
+
+int mm_init(void)
+{
+    void *start;
+
+    root = NULL;
+    small = NULL;
+
+    if((start = mem_sbrk(4*WSIZE)) == (void*) -1)
+        return -1;
+
+    PUT(start, 0);
+    PUT(start + (WSIZE), PACK(DSIZE, 1));
+    PUT(start + (2*WSIZE), PACK(DSIZE, 1));
+    PUT(start + (3*WSIZE), PACK(0,1));
+
+    if(extend_heap(CHUNKSIZE/WSIZE) == NULL)
+        return -1;
+
+    return 0;
+}
+
+static void *extend_heap(uint32_t words)
+{
+    void *bp;
+    uint32_t size;
+    size = (words%2) ? (words+1) * WSIZE : words * WSIZE;
+    if((bp = mem_sbrk(size)) == (void*) -1)
+        return NULL;
+
+    PUT(HDRP(bp), PACK(size, 0));
+    PUT(FTRP(bp), PACK(size, 0));
+    PUT(HDRP(NEXT_BLKP(bp)), PACK(0,1));
+
+    return coalesce(bp);
+}
+
+void *mm_malloc(size_t size)
+{
+    uint32_t asize;
+    uint32_t extendsize;
+    void *bp;
+
+    if(size == 0 || size > UINT32_MAX / 2)
+    {
+        return NULL;
+    }
+    else if(size <= DSIZE)
+    {
+        size = 2*DSIZE;
+    }
+    else if((size%DSIZE) != 0)
+    {
+        uint32_t times = size/DSIZE;
+        size = (times+1)* DSIZE;
+    }
+    asize = size + DSIZE;
+    if((bp = find_fit(asize)) != NULL)
+    {
+        place(bp, asize);
+        return bp;
+    }
+
+    extendsize = MAX(asize, CHUNKSIZE);
+    if((bp = extend_heap(extendsize/WSIZE)) == NULL)
+        return NULL;
+
+    place(bp, asize);
+    return bp;
+}
+
+static void *find_fit(uint32_t asize)
+{
+    tnode *t = root;
+
+    if(asize < TREE_MIN && small != NULL)
+    {
+        return small;
+    }
+    if(MAXOF(t) < asize)
+    {
+        return NULL;
+    }
+
+    /* leftmost block that fits: lower addresses first, then this node */
+    for(;;)
+    {
+        if(MAXOF(t->left) >= asize)
+            t = t->left;
+        else if(GET_SIZE(HDRP(t)) >= asize)
+            return t;
+        else
+            t = t->right;
+    }
+}
+
+static void place(void *bp, uint32_t asize)
+{
+    uint32_t csize = GET_SIZE(HDRP(bp));
+
+    remove_from_free((freelist*)bp);
+    if((csize - asize) >= MINIMUM)
+    {
+        PUT(HDRP(bp), PACK(asize, 1));
+        PUT(FTRP(bp), PACK(asize, 1));
+
+        bp = NEXT_BLKP(bp);
+        PUT(HDRP(bp), PACK(csize - asize, 0));
+        PUT(FTRP(bp), PACK(csize - asize, 0));
+        insert_to_free((freelist*)bp);
+    }
+    else
+    {
+        PUT(HDRP(bp), PACK(csize, 1));
+        PUT(FTRP(bp), PACK(csize, 1));
+    }
+}
+
+static void remove_from_free(freelist* bp)
+{
+    if(GET_SIZE(HDRP(bp)) >= TREE_MIN)
+    {
+        root = tree_remove(root, (tnode*)bp);
+        return;
+    }
+
+    if(bp->prev == NULL)
+        small = bp->next;
+    else
+        bp->prev->next = bp->next;
+    if(bp->next != NULL)
+        bp->next->prev = bp->prev;
+}
+
+static void insert_to_free(freelist *bp)
+{
+    if(GET_SIZE(HDRP(bp)) >= TREE_MIN)
+    {
+        root = tree_insert(root, (tnode*)bp);
+        return;
+    }
+
+    bp->prev = NULL;
+    bp->next = small;
+    if(small != NULL)
+        small->prev = bp;
+    small = bp;
+}
+
+void mm_free(void *bp)
+{
+    if(bp == 0)
+        return;
+
+    uint32_t size = GET_SIZE(HDRP(bp));
+
+    PUT(HDRP(bp), PACK(size, 0));
+    PUT(FTRP(bp), PACK(size, 0));
+
+    coalesce(bp);
+}
+
+static void *coalesce(void *bp)
+{
+    size_t prev_alloc = GET_ALLOC(FTRP(PREV_BLKP(bp)));
+    size_t next_alloc = GET_ALLOC(HDRP(NEXT_BLKP(bp)));
+    size_t size = GET_SIZE(HDRP(bp));
+
+    if(!next_alloc)
+    {
+        size = size + GET_SIZE(HDRP(NEXT_BLKP(bp)));
+        remove_from_free((freelist*)NEXT_BLKP(bp));
+    }
+    if(!prev_alloc)
+    {
+        size = size + GET_SIZE(HDRP(PREV_BLKP(bp)));
+        remove_from_free((freelist*)PREV_BLKP(bp));
+        bp = PREV_BLKP(bp);
+    }
+    PUT(HDRP(bp), PACK(size, 0));
+    PUT(FTRP(bp), PACK(size, 0));
+    insert_to_free((freelist*)bp);
+    return bp;
+}
+
+void *mm_realloc(void *ptr, size_t size)
+{
+    void *newp;
+    uint32_t copySize;
+
+    if(size > UINT32_MAX / 2)
+    {
+        return NULL;
+    }
+
+    uint32_t next_alloc = GET_ALLOC(HDRP(NEXT_BLKP(ptr)));
+
+    uint32_t next_size = GET_SIZE(HDRP(NEXT_BLKP(ptr)));
+
+    uint32_t curr_size = GET_SIZE(HDRP(ptr));
+    uint32_t combine_size = curr_size + next_size;
+    uint32_t asize = size + DSIZE;
+
+    if(curr_size > asize)
+    {
+        return ptr;
+    }
+
+    if(!next_alloc && combine_size >= asize)
+    {
+        remove_from_free((freelist*)NEXT_BLKP(ptr));
+        PUT(HDRP(ptr), PACK(combine_size, 1));
+        PUT(FTRP(ptr), PACK(combine_size, 1));
+
+        return ptr;
+    }
+
+    newp = mm_malloc(size);
+    if (newp == NULL)
+    {
+        printf("ERROR: mm_malloc failed in mm_realloc\n");
+        exit(1);
+    }
+    copySize = GET_SIZE(HDRP(ptr));
+    if(size < copySize)
+    {
+        copySize = size;
+    }
+    memcpy(newp, ptr, copySize);
+    mm_free(ptr);
+    return newp;
+}
@@ -123,13 +123,13 @@ static void *extend_heap(uint32_t words)
     return coalesce(bp);
 }
 
-void *mm_malloc(uint32_t size)
+void *mm_malloc(size_t size)
 {
     uint32_t asize;
     uint32_t extendsize;
     void *bp;
     
-    if(size == 0)
+    if(size == 0 || size > UINT32_MAX / 2)
     {
         return NULL;
     }
@@ -321,11 +321,16 @@ static void *coalesce(void *bp)
     return bp;
 }
 
-void *mm_realloc(void *ptr, uint32_t size)
+void *mm_realloc(void *ptr, size_t size)
 {
     void *newp;
     uint32_t copySize;
 
+    if(size > UINT32_MAX / 2)
+    {
+        return NULL;
+    }
+
     uint32_t next_alloc = GET_ALLOC(HDRP(NEXT_BLKP(ptr)));
 
     uint32_t next_size = GET_SIZE(HDRP(NEXT_BLKP(ptr)));
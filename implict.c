@@ -285,13 +285,13 @@ static void *coalesce(void *bp)
 // bytes, your malloc implementation should do likewise and always 
 // return 8-byte aligned pointers.
 
-void *mm_malloc(uint32_t size) 
+void *mm_malloc(size_t size) 
 {
     size_t asize;
     size_t extendsize;
     char* bp;
     
-    if(size == 0)
+    if(size == 0 || size > UINT32_MAX / 2)
         return NULL;
     
     if(size <= DSIZE)
@@ -365,11 +365,16 @@ static void place(void *bp, uint32_t asize)
         irst 4 bytes of the old block. 
 */
 
-void *mm_realloc(void *ptr, uint32_t size)
+void *mm_realloc(void *ptr, size_t size)
 {
     void *newp;
     uint32_t copySize;
 
+    if(size > UINT32_MAX / 2)
+    {
+        return NULL;
+    }
+
     newp = mm_malloc(size);
     if (newp == NULL)
     {
@@ -14,6 +14,7 @@
 #include <string.h>
 #include <assert.h>
 #include <float.h>
+#include <limits.h>
 #include <time.h>
 
 #include "mm.h"
@@ -29,10 +30,17 @@
 #define MAXLINE     1024 /* max string size */
 #define HDRLINES       4 /* number of header lines in a trace file */
 #define LINENUM(i) (i+5) /* cnvt trace request nums to linenums (origin 1) */
+#define MAX(x, y) ((x) > (y) ? (x) : (y))
 
 /* Returns true if p is ALIGNMENT-byte aligned */
 #define IS_ALIGNED(p)  ((((uintptr_t)(p)) % ALIGNMENT) == 0)
 
+/* Allocators only need the calls past malloc/free/realloc to run traces that use them */
+#pragma weak mm_memalign
+#pragma weak mm_calloc
+#pragma weak mm_malloc_batch
+#pragma weak mm_free_batch
+
 /****************************** 
  * The key compound data types 
  *****************************/
@@ -45,11 +53,16 @@ typedef struct range_t {
 } range_t;
 
 /* Characterizes a single trace operation (allocator request) */
-typedef enum {ALLOC, FREE, REALLOC} RequestType;
+typedef enum {ALLOC, FREE, REALLOC, MEMALIGN, CALLOC, BATCH, FREE_BATCH}
+    RequestType;
 typedef struct {
     RequestType type; /* type of request */
     int index;                        /* index for free() to use later */
     int size;                         /* byte size of alloc/realloc request */
+    int align;                        /* alignment of a memalign request */
+    int nmemb;                        /* elements of a calloc request */
+    int count;                        /* blocks of a batch request */
+    int *ids;                         /* ids freed by a batch free */
 } traceop_t;
 
 /* Holds the information for one trace file*/
@@ -61,6 +74,7 @@ typedef struct {
     traceop_t *ops;      /* array of requests */
     char **blocks;       /* array of ptrs returned by malloc/realloc... */
     size_t *block_sizes; /* ... and a corresponding array of payload sizes */
+    void **batch;        /* pointers handed to a batch free */
 } trace_t;
 
 /* 
@@ -151,6 +165,7 @@ int main(int argc, char **argv)
     int team_check = 1;  /* If set, check team structure (reset by -a) */
     int run_libc = 0;    /* If set, run libc malloc (set by -l) */
     int autograder = 0;  /* If set, emit summary info for autograder (-g) */
+    size_t max_heap = MAX_HEAP; /* simulated heap size in bytes (-H) */
 
     /* temporaries used to compute the performance index */
     double secs, ops, util, avg_mm_util, avg_mm_throughput, p1, p2, perfindex;
@@ -159,7 +174,7 @@ int main(int argc, char **argv)
     /* 
      * Read and interpret the command line arguments 
      */
-    while ((c = getopt(argc, argv, "f:t:hvVgal")) != EOF) {
+    while ((c = getopt(argc, argv, "f:t:H:hvVgal")) != EOF) {
         switch (c) {
 	case 'g': /* Generate summary info for the autograder */
 	    autograder = 1;
@@ -180,6 +195,13 @@ int main(int argc, char **argv)
 	    if (tracedir[strlen(tracedir)-1] != '/') 
 		strcat(tracedir, "/"); /* path always ends with "/" */
 	    break;
+	case 'H': /* Size of the simulated heap in MB */
+	    max_heap = (size_t)atol(optarg) << 20;
+	    if (max_heap == 0) {
+		usage();
+		exit(1);
+	    }
+	    break;
         case 'a': /* Don't check team structure */
             team_check = 0;
             break;
@@ -287,7 +309,7 @@ int main(int argc, char **argv)
 	unix_error("mm_stats calloc in main failed");
     
     /* Initialize the simulated memory system in memlib.c */
-    mem_init(); 
+    mem_init_size(max_heap); 
 
     /* Evaluate student's mm malloc package using the K-best scheme */
     for (i=0; i < num_tracefiles; i++) {
@@ -397,9 +419,10 @@ static int add_range(range_t **ranges, char *lo, int size,
         return 0;
     }
 
-    /* The payload must lie within the extent of the heap */
-    if ((lo < (char *)mem_heap_lo()) || (lo > (char *)mem_heap_hi()) || 
-	(hi < (char *)mem_heap_lo()) || (hi > (char *)mem_heap_hi())) {
+    /* The payload must lie within the extent of the heap, or of mem_map */
+    if (((lo < (char *)mem_heap_lo()) || (lo > (char *)mem_heap_hi()) || 
+	 (hi < (char *)mem_heap_lo()) || (hi > (char *)mem_heap_hi())) &&
+	((lo < (char *)mem_map_lo()) || (hi > (char *)mem_map_hi()))) {
 	sprintf(msg, "Payload (%p:%p) lies outside heap (%p:%p)",
 		lo, hi, mem_heap_lo(), mem_heap_hi());
 	malloc_error(tracenum, opnum, msg);
@@ -478,8 +501,10 @@ static trace_t *read_trace(char *tracedir, char *filename)
     trace_t *trace;
     char type[MAXLINE];
     char path[MAXLINE];
-    int index, size;
+    int index, size, align, nmemb, count;
     int max_index = 0;
+    int max_count = 0;
+    int j;
     int op_index;
 
     if (verbose > 1)
@@ -547,6 +572,61 @@ static trace_t *read_trace(char *tracedir, char *filename)
 	    trace->ops[op_index].size = size;
 	    max_index = (index > max_index) ? index : max_index;
 	    break;
+	case 'm':
+	  if ( 3 != fscanf(tracefile, "%u %u %u", &index, &align, &size) ) {
+	    unix_error("fscanf of memalign");
+	  }
+	    if (align == 0 || (align & (align - 1)) != 0) {
+		printf("Alignment %d is not a power of two in tracefile %s\n",
+		       align, path);
+		exit(1);
+	    }
+	    trace->ops[op_index].type = MEMALIGN;
+	    trace->ops[op_index].index = index;
+	    trace->ops[op_index].size = size;
+	    trace->ops[op_index].align = align;
+	    max_index = (index > max_index) ? index : max_index;
+	    break;
+	case 'c':
+	  if ( 3 != fscanf(tracefile, "%u %u %u", &index, &nmemb, &size) ) {
+	    unix_error("fscanf of calloc");
+	  }
+	    if (nmemb == 0) {
+		printf("calloc of 0 elements in tracefile %s\n", path);
+		exit(1);
+	    }
+	    if ((unsigned)size > INT_MAX / (unsigned)nmemb) {
+		printf("calloc of %u * %u bytes overflows in tracefile %s\n",
+		       (unsigned)nmemb, (unsigned)size, path);
+		exit(1);
+	    }
+	    /* size is the whole block, which the other ops work with */
+	    trace->ops[op_index].type = CALLOC;
+	    trace->ops[op_index].index = index;
+	    trace->ops[op_index].size = nmemb * size;
+	    trace->ops[op_index].nmemb = nmemb;
+	    max_index = (index > max_index) ? index : max_index;
+	    break;
+	case 'b':
+	  if ( 3 != fscanf(tracefile, "%u %u %u", &index, &count, &size) ) {
+	    unix_error("fscanf of batch malloc");
+	  }
+	    if (count == 0) {
+		printf("batch of 0 blocks in tracefile %s\n", path);
+		exit(1);
+	    }
+	    if ((unsigned)size > INT_MAX / (unsigned)count) {
+		printf("batch of %u * %u bytes overflows in tracefile %s\n",
+		       (unsigned)count, (unsigned)size, path);
+		exit(1);
+	    }
+	    /* blocks index to index + count - 1, each of size bytes */
+	    trace->ops[op_index].type = BATCH;
+	    trace->ops[op_index].index = index;
+	    trace->ops[op_index].size = size;
+	    trace->ops[op_index].count = count;
+	    max_index = (index + count - 1 > max_index) ? index + count - 1 : max_index;
+	    break;
 	case 'f':
 	  if ( 1 != fscanf(tracefile, "%ud", &index) ) {
 	    unix_error("fscanf of free\n");
@@ -554,6 +634,27 @@ static trace_t *read_trace(char *tracedir, char *filename)
 	    trace->ops[op_index].type = FREE;
 	    trace->ops[op_index].index = index;
 	    break;
+	case 'F':
+	  if ( 1 != fscanf(tracefile, "%u", &count) ) {
+	    unix_error("fscanf of batch free");
+	  }
+	    if (count == 0 || count > trace->num_ids) {
+		printf("batch free of %u blocks in tracefile %s\n",
+		       (unsigned)count, path);
+		exit(1);
+	    }
+	    if ((trace->ops[op_index].ids =
+		 (int *)malloc(count * sizeof(int))) == NULL)
+		unix_error("malloc 5 failed in read_trace");
+	    for (j = 0; j < count; j++) {
+		if ( 1 != fscanf(tracefile, "%u", &trace->ops[op_index].ids[j]) ) {
+		    unix_error("fscanf of batch free id");
+		}
+	    }
+	    trace->ops[op_index].type = FREE_BATCH;
+	    trace->ops[op_index].count = count;
+	    max_count = (count > max_count) ? count : max_count;
+	    break;
 	default:
 	    printf("Bogus type character (%c) in tracefile %s\n", 
 		   type[0], path);
@@ -565,19 +666,30 @@ static trace_t *read_trace(char *tracedir, char *filename)
     fclose(tracefile);
     assert(max_index == trace->num_ids - 1);
     assert(trace->num_ops == op_index);
+
+    /* Batch frees gather their pointers here, with room for a NULL */
+    if ((trace->batch =
+	 (void **)malloc((max_count + 1) * sizeof(void *))) == NULL)
+	unix_error("malloc 6 failed in read_trace");
     
     return trace;
 }
 
 /*
- * free_trace - Free the trace record and the three arrays it points
+ * free_trace - Free the trace record and the arrays it points
  *              to, all of which were allocated in read_trace().
  */
 void free_trace(trace_t *trace)
 {
-    free(trace->ops);         /* free the three arrays... */
+    int i;
+
+    for (i = 0; i < trace->num_ops; i++)
+	if (trace->ops[i].type == FREE_BATCH)
+	    free(trace->ops[i].ids);
+    free(trace->ops);         /* free the arrays... */
     free(trace->blocks);      
     free(trace->block_sizes);
+    free(trace->batch);
     free(trace);              /* and the trace record itself... */
 }
 
@@ -644,6 +756,73 @@ static int eval_mm_valid(trace_t *trace, int tracenum, range_t **ranges)
 	    trace->block_sizes[index] = size;
 	    break;
 
+        case MEMALIGN: /* mm_memalign */
+
+	    if (mm_memalign == NULL) {
+		malloc_error(tracenum, i, "mm_memalign is not implemented.");
+		return 0;
+	    }
+	    if ((p = (char *) mm_memalign(trace->ops[i].align, size)) == NULL) {
+		malloc_error(tracenum, i, "mm_memalign failed.");
+		return 0;
+	    }
+	    if ((uintptr_t)p % trace->ops[i].align != 0) {
+		sprintf(msg, "Payload address (%p) not aligned to %d bytes",
+			p, trace->ops[i].align);
+		malloc_error(tracenum, i, msg);
+		return 0;
+	    }
+	    if (add_range(ranges, p, size, tracenum, i) == 0)
+		return 0;
+	    memset(p, index & 0xFF, size);
+	    trace->blocks[index] = p;
+	    trace->block_sizes[index] = size;
+	    break;
+
+        case CALLOC: /* mm_calloc */
+
+	    if (mm_calloc == NULL) {
+		malloc_error(tracenum, i, "mm_calloc is not implemented.");
+		return 0;
+	    }
+	    if ((p = (char *) mm_calloc(trace->ops[i].nmemb,
+					size / trace->ops[i].nmemb)) == NULL) {
+		malloc_error(tracenum, i, "mm_calloc failed.");
+		return 0;
+	    }
+	    if (add_range(ranges, p, size, tracenum, i) == 0)
+		return 0;
+	    for (j = 0; j < size; j++) {
+		if (p[j] != 0) {
+		    malloc_error(tracenum, i, "mm_calloc did not zero the block");
+		    return 0;
+		}
+	    }
+	    memset(p, index & 0xFF, size);
+	    trace->blocks[index] = p;
+	    trace->block_sizes[index] = size;
+	    break;
+
+        case BATCH: /* mm_malloc_batch */
+
+	    if (mm_malloc_batch == NULL) {
+		malloc_error(tracenum, i, "mm_malloc_batch is not implemented.");
+		return 0;
+	    }
+	    if (mm_malloc_batch(size, trace->ops[i].count,
+				(void **)&trace->blocks[index]) !=
+		(size_t)trace->ops[i].count) {
+		malloc_error(tracenum, i, "mm_malloc_batch failed.");
+		return 0;
+	    }
+	    for (j = index; j < index + trace->ops[i].count; j++) {
+		if (add_range(ranges, trace->blocks[j], size, tracenum, i) == 0)
+		    return 0;
+		memset(trace->blocks[j], j & 0xFF, size);
+		trace->block_sizes[j] = size;
+	    }
+	    break;
+
         case REALLOC: /* mm_realloc */
 	    
 	    /* Call the student's realloc */
@@ -689,6 +868,23 @@ static int eval_mm_valid(trace_t *trace, int tracenum, range_t **ranges)
 	    mm_free(p);
 	    break;
 
+        case FREE_BATCH: /* mm_free_batch */
+
+	    if (mm_free_batch == NULL) {
+		malloc_error(tracenum, i, "mm_free_batch is not implemented.");
+		return 0;
+	    }
+	    for (j = 0; j < trace->ops[i].count; j++) {
+		p = trace->blocks[trace->ops[i].ids[j]];
+		remove_range(ranges, p);
+		trace->batch[j] = p;
+	    }
+
+	    /* A NULL in the batch must be skipped, as free(NULL) is */
+	    trace->batch[j] = NULL;
+	    mm_free_batch(trace->batch, j + 1);
+	    break;
+
 	default:
 	    app_error("Nonexistent request type in eval_mm_valid");
         }
@@ -707,12 +903,14 @@ static int eval_mm_valid(trace_t *trace, int tracenum, range_t **ranges)
  *   size of the heap in bytes after running the student's malloc 
  *   package on the trace. Note that our implementation of mem_sbrk() 
  *   doesn't allow the students to decrement the brk pointer, so brk
- *   is always the high water mark of the heap. 
+ *   is always the high water mark of the heap. Blocks mapped with
+ *   mem_map can be given back, so heapsize is really the most heap
+ *   plus mapped memory held at any one time (mem_footprint).
  *   
  */
 static double eval_mm_util(trace_t *trace, int tracenum, range_t **ranges)
 {   
-    int i;
+    int i, j;
     int index;
     int size, newsize, oldsize;
     int max_total_size = 0;
@@ -729,11 +927,26 @@ static double eval_mm_util(trace_t *trace, int tracenum, range_t **ranges)
         switch (trace->ops[i].type) {
 
         case ALLOC: /* mm_alloc */
+        case MEMALIGN: /* mm_memalign */
+        case CALLOC: /* mm_calloc */
 	    index = trace->ops[i].index;
 	    size = trace->ops[i].size;
 
-	    if ((p = (char *) mm_malloc(size)) == NULL) 
-		app_error("mm_malloc failed in eval_mm_util");
+	    if (trace->ops[i].type == MEMALIGN)
+		p = (char *) mm_memalign(trace->ops[i].align, size);
+	    else if (trace->ops[i].type == CALLOC)
+		p = (char *) mm_calloc(trace->ops[i].nmemb,
+				       size / trace->ops[i].nmemb);
+	    else
+		p = (char *) mm_malloc(size);
+	    if (p == NULL) {
+		if (trace->ops[i].type == MEMALIGN)
+		    app_error("mm_memalign failed in eval_mm_util");
+		else if (trace->ops[i].type == CALLOC)
+		    app_error("mm_calloc failed in eval_mm_util");
+		else
+		    app_error("mm_malloc failed in eval_mm_util");
+	    }
 	    
 	    /* Remember region and size */
 	    trace->blocks[index] = p;
@@ -748,6 +961,22 @@ static double eval_mm_util(trace_t *trace, int tracenum, range_t **ranges)
 		total_size : max_total_size;
 	    break;
 
+	case BATCH: /* mm_malloc_batch */
+	    index = trace->ops[i].index;
+	    size = trace->ops[i].size;
+
+	    if (mm_malloc_batch(size, trace->ops[i].count,
+				(void **)&trace->blocks[index]) !=
+		(size_t)trace->ops[i].count)
+		app_error("mm_malloc_batch failed in eval_mm_util");
+	    for (j = index; j < index + trace->ops[i].count; j++)
+		trace->block_sizes[j] = size;
+
+	    total_size += trace->ops[i].count * size;
+	    max_total_size = (total_size > max_total_size) ?
+		total_size : max_total_size;
+	    break;
+
 	case REALLOC: /* mm_realloc */
 	    index = trace->ops[i].index;
 	    newsize = trace->ops[i].size;
@@ -783,13 +1012,22 @@ static double eval_mm_util(trace_t *trace, int tracenum, range_t **ranges)
 	    
 	    break;
 
+        case FREE_BATCH: /* mm_free_batch */
+	    for (j = 0; j < trace->ops[i].count; j++) {
+		index = trace->ops[i].ids[j];
+		trace->batch[j] = trace->blocks[index];
+		total_size -= trace->block_sizes[index];
+	    }
+	    mm_free_batch(trace->batch, trace->ops[i].count);
+	    break;
+
 	default:
 	    app_error("Nonexistent request type in eval_mm_util");
 
         }
     }
 
-    return ((double)max_total_size / (double)mem_heapsize());
+    return ((double)max_total_size / (double)mem_footprint());
 }
 
 
@@ -799,7 +1037,7 @@ static double eval_mm_util(trace_t *trace, int tracenum, range_t **ranges)
  */
 static void eval_mm_speed(void *ptr)
 {
-    int i, index, size, newsize;
+    int i, j, index, size, newsize;
     char *p, *newp, *oldp, *block;
     trace_t *trace = ((speed_t *)ptr)->trace;
 
@@ -820,6 +1058,31 @@ static void eval_mm_speed(void *ptr)
             trace->blocks[index] = p;
             break;
 
+        case MEMALIGN: /* mm_memalign */
+            index = trace->ops[i].index;
+            size = trace->ops[i].size;
+            if ((p = (char *) mm_memalign(trace->ops[i].align, size)) == NULL)
+		app_error("mm_memalign error in eval_mm_speed");
+            trace->blocks[index] = p;
+            break;
+
+        case CALLOC: /* mm_calloc */
+            index = trace->ops[i].index;
+            size = trace->ops[i].size;
+            if ((p = (char *) mm_calloc(trace->ops[i].nmemb,
+					size / trace->ops[i].nmemb)) == NULL)
+		app_error("mm_calloc error in eval_mm_speed");
+            trace->blocks[index] = p;
+            break;
+
+        case BATCH: /* mm_malloc_batch */
+            index = trace->ops[i].index;
+            if (mm_malloc_batch(trace->ops[i].size, trace->ops[i].count,
+				(void **)&trace->blocks[index]) !=
+		(size_t)trace->ops[i].count)
+		app_error("mm_malloc_batch error in eval_mm_speed");
+            break;
+
 	case REALLOC: /* mm_realloc */
 	    index = trace->ops[i].index;
             newsize = trace->ops[i].size;
@@ -835,6 +1098,12 @@ static void eval_mm_speed(void *ptr)
             mm_free(block);
             break;
 
+        case FREE_BATCH: /* mm_free_batch */
+            for (j = 0; j < trace->ops[i].count; j++)
+		trace->batch[j] = trace->blocks[trace->ops[i].ids[j]];
+            mm_free_batch(trace->batch, trace->ops[i].count);
+            break;
+
 	default:
 	    app_error("Nonexistent request type in eval_mm_valid");
         }
@@ -848,7 +1117,7 @@ static void eval_mm_speed(void *ptr)
  */
 static int eval_libc_valid(trace_t *trace, int tracenum)
 {
-    int i, newsize;
+    int i, j, newsize;
     char *p, *newp, *oldp;
 
     for (i = 0;  i < trace->num_ops;  i++) {
@@ -862,6 +1131,34 @@ static int eval_libc_valid(trace_t *trace, int tracenum)
 	    trace->blocks[trace->ops[i].index] = p;
 	    break;
 
+        case MEMALIGN: /* posix_memalign */
+	    if (posix_memalign((void **)&p, MAX(trace->ops[i].align, sizeof(void *)),
+			       trace->ops[i].size) != 0) {
+		malloc_error(tracenum, i, "libc posix_memalign failed");
+		unix_error("System message");
+	    }
+	    trace->blocks[trace->ops[i].index] = p;
+	    break;
+
+        case CALLOC: /* calloc */
+	    if ((p = (char *) calloc(trace->ops[i].nmemb, trace->ops[i].size /
+				     trace->ops[i].nmemb)) == NULL) {
+		malloc_error(tracenum, i, "libc calloc failed");
+		unix_error("System message");
+	    }
+	    trace->blocks[trace->ops[i].index] = p;
+	    break;
+
+        case BATCH: /* one malloc per block */
+	    for (j = 0; j < trace->ops[i].count; j++) {
+		if ((p = (char *) malloc(trace->ops[i].size)) == NULL) {
+		    malloc_error(tracenum, i, "libc malloc failed");
+		    unix_error("System message");
+		}
+		trace->blocks[trace->ops[i].index + j] = p;
+	    }
+	    break;
+
 	case REALLOC: /* realloc */
             newsize = trace->ops[i].size;
 	    oldp = trace->blocks[trace->ops[i].index];
@@ -876,6 +1173,11 @@ static int eval_libc_valid(trace_t *trace, int tracenum)
 	    free(trace->blocks[trace->ops[i].index]);
 	    break;
 
+        case FREE_BATCH: /* one free per block */
+	    for (j = 0; j < trace->ops[i].count; j++)
+		free(trace->blocks[trace->ops[i].ids[j]]);
+	    break;
+
 	default:
 	    app_error("invalid operation type  in eval_libc_valid");
 	}
@@ -891,7 +1193,7 @@ static int eval_libc_valid(trace_t *trace, int tracenum)
  */
 static void eval_libc_speed(void *ptr)
 {
-    int i;
+    int i, j;
     int index, size, newsize;
     char *p, *newp, *oldp, *block;
     trace_t *trace = ((speed_t *)ptr)->trace;
@@ -906,6 +1208,34 @@ static void eval_libc_speed(void *ptr)
 	    trace->blocks[index] = p;
 	    break;
 
+        case MEMALIGN: /* posix_memalign */
+	    index = trace->ops[i].index;
+	    size = trace->ops[i].size;
+	    if (posix_memalign((void **)&p, MAX(trace->ops[i].align, sizeof(void *)),
+			       size) != 0)
+		unix_error("posix_memalign failed in eval_libc_speed");
+	    trace->blocks[index] = p;
+	    break;
+
+        case CALLOC: /* calloc */
+	    index = trace->ops[i].index;
+	    size = trace->ops[i].size;
+	    if ((p = (char *) calloc(trace->ops[i].nmemb,
+				     size / trace->ops[i].nmemb)) == NULL)
+		unix_error("calloc failed in eval_libc_speed");
+	    trace->blocks[index] = p;
+	    break;
+
+        case BATCH: /* one malloc per block */
+	    index = trace->ops[i].index;
+	    size = trace->ops[i].size;
+	    for (j = 0; j < trace->ops[i].count; j++) {
+		if ((p = (char *) malloc(size)) == NULL)
+		    unix_error("malloc failed in eval_libc_speed");
+		trace->blocks[index + j] = p;
+	    }
+	    break;
+
 	case REALLOC: /* realloc */
 	    index = trace->ops[i].index;
 	    newsize = trace->ops[i].size;
@@ -921,6 +1251,11 @@ static void eval_libc_speed(void *ptr)
 	    block = trace->blocks[index];
 	    free(block);
 	    break;
+
+        case FREE_BATCH: /* one free per block */
+	    for (j = 0; j < trace->ops[i].count; j++)
+		free(trace->blocks[trace->ops[i].ids[j]]);
+	    break;
 	}
     }
 }
@@ -1019,12 +1354,13 @@ void malloc_error(int tracenum, int opnum, const char *msg)
  */
 static void usage(void) 
 {
-    fprintf(stderr, "Usage: mdriver [-hvVal] [-f <file>] [-t <dir>]\n");
+    fprintf(stderr, "Usage: mdriver [-hvVal] [-f <file>] [-t <dir>] [-H <mb>]\n");
     fprintf(stderr, "Options\n");
     fprintf(stderr, "\t-a         Don't check the team structure.\n");
     fprintf(stderr, "\t-f <file>  Use <file> as the trace file.\n");
     fprintf(stderr, "\t-g         Generate summary info for autograder.\n");
     fprintf(stderr, "\t-h         Print this message.\n");
+    fprintf(stderr, "\t-H <mb>    Simulate a heap of <mb> megabytes.\n");
     fprintf(stderr, "\t-l         Run libc malloc as well.\n");
     fprintf(stderr, "\t-t <dir>   Directory to find default traces.\n");
     fprintf(stderr, "\t-v         Print per-trace performance breakdowns.\n");
@@ -10,6 +10,7 @@
 #include <sys/mman.h>
 #include <string.h>
 #include <errno.h>
+#include <stdint.h>
 
 #include "memlib.h"
 #include "config.h"
@@ -18,20 +19,70 @@
 char *mem_start_brk;  /* points to first byte of heap */
 static char *mem_brk;        /* points to last byte of heap */
 static char *mem_max_addr;   /* largest legal heap address */ 
+static size_t mem_max_heap;  /* bytes reserved for the heap */
+static char *mem_dirty;      /* highest brk since mem_init */
+
+/*
+ * mmap model: a separate MAX_MAP byte range carved into MAP_PAGE
+ * pages, with one byte per page saying whether it is mapped, or
+ * unmapped but written to since mem_init
+ */
+#define MAP_PAGES (MAX_MAP / MAP_PAGE)
+#define PAGE_CLEAN 0
+#define PAGE_MAPPED 1
+#define PAGE_DIRTY 2
+static char *mem_map_raw;           /* storage as returned by malloc */
+static char *mem_map_start;         /* first byte of the range, page aligned */
+static unsigned char mem_mapped[MAP_PAGES];
+static size_t mem_map_bytes;        /* bytes mapped right now */
+static size_t mem_peak;             /* most heap plus mapped bytes so far */
+
+static void mem_note_peak(void)
+{
+    size_t now = (size_t)(mem_brk - mem_start_brk) + mem_map_bytes;
+
+    if (now > mem_peak)
+	mem_peak = now;
+}
 
 /* 
- * mem_init - initialize the memory system model
+ * mem_init - initialize the memory system model with a MAX_HEAP heap
  */
 void mem_init(void)
 {
-    /* allocate the storage we will use to model the available VM */
-    if ((mem_start_brk = (char *)malloc(MAX_HEAP)) == NULL) {
-	fprintf(stderr, "mem_init_vm: malloc error\n");
+    mem_init_size(MAX_HEAP);
+}
+
+/*
+ * mem_init_size - initialize the memory system model with a heap of
+ *    up to max_heap bytes. The storage is reserved, not committed, so
+ *    a heap larger than physical memory only costs what sbrk reaches.
+ */
+void mem_init_size(size_t max_heap)
+{
+    /* reserve the storage we will use to model the available VM */
+    mem_start_brk = mmap(NULL, max_heap, PROT_READ | PROT_WRITE,
+			 MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (mem_start_brk == MAP_FAILED) {
+	fprintf(stderr, "mem_init_vm: mmap error\n");
 	exit(1);
     }
 
-    mem_max_addr = mem_start_brk + MAX_HEAP;  /* max legal heap address */
+    mem_max_heap = max_heap;
+    mem_max_addr = mem_start_brk + max_heap;  /* max legal heap address */
     mem_brk = mem_start_brk;                  /* heap is empty initially */
+    mem_dirty = mem_start_brk;
+
+    /* and the range mappings come from, aligned like real ones */
+    if ((mem_map_raw = (char *)calloc(1, MAX_MAP + MAP_PAGE)) == NULL) {
+	fprintf(stderr, "mem_init_vm: malloc error\n");
+	exit(1);
+    }
+    mem_map_start = (char *)(((uintptr_t)mem_map_raw + MAP_PAGE - 1) &
+			     ~(uintptr_t)(MAP_PAGE - 1));
+    memset(mem_mapped, PAGE_CLEAN, sizeof(mem_mapped));
+    mem_map_bytes = 0;
+    mem_peak = 0;
 }
 
 /* 
@@ -39,32 +90,48 @@ void mem_init(void)
  */
 void mem_deinit(void)
 {
-    free(mem_start_brk);
+    munmap(mem_start_brk, mem_max_heap);
+    free(mem_map_raw);
 }
 
 /*
- * mem_reset_brk - reset the simulated brk pointer to make an empty heap
+ * mem_reset_brk - reset the simulated brk pointer to make an empty heap,
+ *    dropping every mapping along with it
  */
 void mem_reset_brk()
 {
+    size_t i;
+
     mem_brk = mem_start_brk;
+    for (i = 0; i < MAP_PAGES; i++)
+	if (mem_mapped[i] == PAGE_MAPPED)
+	    mem_mapped[i] = PAGE_DIRTY;
+    mem_map_bytes = 0;
+    mem_peak = 0;
 }
 
 /* 
  * mem_sbrk - simple model of the sbrk function. Extends the heap 
- *    by incr bytes and returns the start address of the new area. In
- *    this model, the heap cannot be shrunk.
+ *    by incr bytes and returns the start address of the new area,
+ *    which like fresh memory from the kernel reads as zero. In this
+ *    model, the heap cannot be shrunk.
  */
-void *mem_sbrk(int incr) 
+void *mem_sbrk(intptr_t incr) 
 {
     char *old_brk = mem_brk;
 
-    if ( (incr < 0) || ((mem_brk + incr) > mem_max_addr)) {
+    if ( (incr < 0) || (incr > mem_max_addr - mem_brk)) {
 	errno = ENOMEM;
 	fprintf(stderr, "ERROR: mem_sbrk failed. Ran out of memory...\n");
 	return (void *)-1;
     }
+    /* clear whatever a run before the last mem_reset_brk left there */
+    if (old_brk < mem_dirty)
+	memset(old_brk, 0, incr < mem_dirty - old_brk ? incr : mem_dirty - old_brk);
     mem_brk += incr;
+    if (mem_brk > mem_dirty)
+	mem_dirty = mem_brk;
+    mem_note_peak();
     return (void *)old_brk;
 }
 
@@ -92,6 +159,14 @@ size_t mem_heapsize()
     return (size_t)(mem_brk - mem_start_brk);
 }
 
+/*
+ * mem_heap_max() - returns the most bytes the heap can grow to
+ */
+size_t mem_heap_max()
+{
+    return mem_max_heap;
+}
+
 /*
  * mem_pagesize() - returns the page size of the system
  */
@@ -99,3 +174,76 @@ size_t mem_pagesize()
 {
     return (size_t)getpagesize();
 }
+
+/*
+ * mem_map - simple model of an anonymous mmap. Returns size bytes,
+ *    rounded up to whole MAP_PAGEs and zeroed, at a page aligned address
+ *    outside the heap, or (void *)-1 if no run of pages that long is free.
+ */
+void *mem_map(size_t size)
+{
+    size_t pages = (size + MAP_PAGE - 1) / MAP_PAGE;
+    size_t i, j, run = 0;
+
+    for (i = 0; i < MAP_PAGES && pages > 0; i++) {
+	run = mem_mapped[i] == PAGE_MAPPED ? 0 : run + 1;
+	if (run == pages) {
+	    i -= pages - 1;
+	    for (j = i; j < i + pages; j++) {
+		if (mem_mapped[j] == PAGE_DIRTY)
+		    memset(mem_map_start + j * MAP_PAGE, 0, MAP_PAGE);
+		mem_mapped[j] = PAGE_MAPPED;
+	    }
+	    mem_map_bytes += pages * MAP_PAGE;
+	    mem_note_peak();
+	    return (void *)(mem_map_start + i * MAP_PAGE);
+	}
+    }
+    errno = ENOMEM;
+    fprintf(stderr, "ERROR: mem_map failed. Ran out of memory...\n");
+    return (void *)-1;
+}
+
+/*
+ * mem_unmap - simple model of munmap, giving back the pages a mem_map
+ *    call returned
+ */
+int mem_unmap(void *addr, size_t size)
+{
+    size_t first = ((char *)addr - mem_map_start) / MAP_PAGE;
+    size_t pages = (size + MAP_PAGE - 1) / MAP_PAGE;
+
+    if ((char *)addr < mem_map_start || first + pages > MAP_PAGES ||
+	((char *)addr - mem_map_start) % MAP_PAGE != 0) {
+	errno = EINVAL;
+	return -1;
+    }
+    memset(&mem_mapped[first], PAGE_DIRTY, pages);
+    mem_map_bytes -= pages * MAP_PAGE;
+    return 0;
+}
+
+/*
+ * mem_map_lo - return address of the first byte mappings can use
+ */
+void *mem_map_lo()
+{
+    return (void *)mem_map_start;
+}
+
+/*
+ * mem_map_hi - return address of the last byte mappings can use
+ */
+void *mem_map_hi()
+{
+    return (void *)(mem_map_start + MAX_MAP - 1);
+}
+
+/*
+ * mem_footprint - returns the most memory, heap plus mappings, in use
+ *    at any one time since the heap was last reset
+ */
+size_t mem_footprint()
+{
+    return mem_peak;
+}
@@ -1,11 +1,19 @@
 #include <unistd.h>
+#include <stdint.h>
 
 void mem_init(void);               
+void mem_init_size(size_t max_heap);
 void mem_deinit(void);
-void *mem_sbrk(int incr);
+void *mem_sbrk(intptr_t incr);
 void mem_reset_brk(void); 
 void *mem_heap_lo(void);
 void *mem_heap_hi(void);
 size_t mem_heapsize(void);
+size_t mem_heap_max(void);
 size_t mem_pagesize(void);
+void *mem_map(size_t size);
+int mem_unmap(void *addr, size_t size);
+void *mem_map_lo(void);
+void *mem_map_hi(void);
+size_t mem_footprint(void);
 
@@ -4,6 +4,12 @@
 #include <memory.h>
 #include "mm.h"
 #include "memlib.h"
+#include "config.h"
+#include "sizeclass.h"
+#include <sys/mman.h>
+#ifdef MM_THREADS
+#include <pthread.h>
+#endif
 
 team_t team = {
     "The BOI",
@@ -13,33 +19,243 @@ team_t team = {
     "chso8299@colorado.edu"
 };
 
-#define WSIZE       4       
-#define DSIZE       8       
+/*
+ * Boundary tags are 32-bit words by default, which caps a block at
+ * 4 GB and, with COMPACT_LINKS, the whole heap too. WIDE_TAGS makes
+ * them 64-bit words for heaps and blocks of any size: payloads are
+ * then 16-byte aligned and the smallest block is 32 bytes, so the
+ * compact format stays the default for small-object-heavy programs.
+ */
+#ifndef WIDE_TAGS
+#define WIDE_TAGS   0
+#endif
+
+#if WIDE_TAGS
+typedef uint64_t word_t;
+#define WSIZE       8
+#define DSIZE       16
+#else
+typedef uint32_t word_t;
+#define WSIZE       4
+#define DSIZE       8
+#endif
 #define CHUNKSIZE  (1<<8)  
-#define OVERHEAD    8
+#define OVERHEAD    WSIZE
+
+/* largest request served, small enough that ADJUST and SLACK cannot overflow */
+#define MAX_REQUEST ((word_t)-1 / 2)
+
+/*
+ * With COMPACT_LINKS the free-list links are 32-bit offsets from
+ * the start of the heap instead of native pointers. Headers already
+ * limit the heap to 32-bit sizes, and it drops the smallest free
+ * block from 24 to 16 bytes on 64-bit hosts. Offset 0 is the
+ * alignment pad, never a block, so it doubles as the null link.
+ */
+#ifndef COMPACT_LINKS
+#define COMPACT_LINKS (!WIDE_TAGS)
+#endif
+#if COMPACT_LINKS && WIDE_TAGS
+#error "COMPACT_LINKS offsets cannot span a WIDE_TAGS heap"
+#endif
+
+#if WIDE_TAGS
+#define MINIMUM     32
+#elif COMPACT_LINKS
+#define MINIMUM     16
+#else
 #define MINIMUM     24
+#endif
+
+/*
+ * Most bytes the heap may grow to: 32-bit tags and links keep it
+ * under 4 GB, and the threaded build's remote lists hold 32-bit
+ * offsets in DSIZE units.
+ */
+#if !WIDE_TAGS
+#define HEAP_LIMIT  ((size_t)UINT32_MAX)
+#elif defined(MM_THREADS)
+#define HEAP_LIMIT  ((size_t)DSIZE << 32)
+#else
+#define HEAP_LIMIT  SIZE_MAX
+#endif
+
+/*
+ * Only free blocks carry a footer. Bit 1 of every header records
+ * whether the block before it is allocated, which is all coalesce
+ * needs to know before it goes looking for that block's footer.
+ */
+#define PREV_ALLOC  0x2
+
+/*
+ * Bit 2 of an allocated block's header is set once realloc has grown
+ * it. Growing such a block again by copying reserves SLACK_NUM/
+ * SLACK_DEN extra, up to SLACK_CAP bytes, so later small increments
+ * return straight away. The slack only comes out of free blocks that
+ * are already there, never from growing the heap, and goes back with
+ * the block when it is freed.
+ */
+#define GROWN       0x4
+
+/*
+ * The same bit on a free block says its payload is known to be zero
+ * apart from its own free-list links and footer, as it is when it
+ * comes straight from mem_sbrk. It survives splits, and merges with
+ * blocks that are also zero, so mm_calloc only has to clear those
+ * few words of a block carved out of the untouched wilderness.
+ */
+#define ZEROED      0x4
+#ifndef SLACK_NUM
+#define SLACK_NUM   1
+#define SLACK_DEN   2
+#endif
+#ifndef SLACK_CAP
+#define SLACK_CAP   (64 * 1024)
+#endif
 
-static inline int MAX(int x, int y)
+/* 
+ * Free blocks are kept in NBINS segregated lists. Bins below
+ * EXACT_BINS hold exactly one size each (DSIZE steps), the rest
+ * start at the bin_bounds of sizeclass.h: a power of two each, with
+ * the ranges the traces ask most of split further, and the last
+ * everything larger still. binmap has bit i set iff bins[i] is
+ * non-empty, so the first usable bin is a find-first-set away.
+ */
+#define EXACT_BINS  32
+#define NBINS       (EXACT_BINS + NBOUNDS)
+#if NBINS > 64
+#error "binmap has a bit per bin, sizeclass.h has too many bin_bounds"
+#endif
+
+/*
+ * Good-fit mode bounds the best-fit search of a bin: it takes the
+ * first block within GOOD_PCT percent of the request, or the best of
+ * the first GOOD_PROBES blocks that fit, rather than walking the
+ * whole list. 0 turns either bound off; both off is plain best fit.
+ * "make goodfit" shows the utilization and throughput of a few
+ * settings.
+ */
+#ifndef GOOD_PROBES
+#define GOOD_PROBES 0
+#endif
+#ifndef GOOD_PCT
+#define GOOD_PCT    0
+#endif
+
+/*
+ * Freed blocks of up to QUICK_MAX bytes are not coalesced right away.
+ * They stay marked allocated on a LIFO quick list of their exact
+ * size, where the next request for that size pops them without a
+ * search. consolidate frees them all for real; it runs when a fit
+ * fails and whenever more than QUICK_LIMIT bytes are parked.
+ */
+#ifndef QUICK_MAX
+#define QUICK_MAX   1024
+#endif
+#ifndef QUICK_LIMIT
+#define QUICK_LIMIT (64 * 1024)
+#endif
+#define NQUICK      (QUICK_MAX / DSIZE + 1)
+
+/*
+ * mm_free_batch sorts its blocks by address, BATCH_SORT at a time,
+ * and merges blocks that sit next to each other into one free block
+ * before coalescing it. A run cut at a chunk boundary still merges,
+ * just through coalesce. The header BATCH_AHEAD blocks further on is
+ * prefetched, so it is in cache by the time the walk gets there.
+ */
+#ifndef BATCH_SORT
+#define BATCH_SORT  512
+#endif
+#ifndef BATCH_AHEAD
+#define BATCH_AHEAD 8
+#endif
+
+/*
+ * Small requests grow the heap by an arena's chunk, which starts at
+ * CHUNKSIZE. It doubles, up to CHUNK_MAX, when the heap has to grow
+ * again within CHUNK_BURST mallocs of the last time, and halves back
+ * when growth is rarer than that, so a fast-growing heap makes few
+ * mem_sbrk calls and a slow one overshoots little. Larger requests
+ * take exactly what they are missing.
+ */
+#ifndef CHUNK_MAX
+#define CHUNK_MAX   (1<<16)
+#endif
+#ifndef CHUNK_BURST
+#define CHUNK_BURST 8
+#endif
+
+/*
+ * Requests of at least map_threshold bytes get a mapping of their own
+ * from mem_map rather than a heap block, and free hands the mapping
+ * straight back. The threshold starts at MAP_MIN and, as in glibc,
+ * rises to the length of each mapped block freed, up to MAP_MAX, so
+ * sizes a program keeps allocating and freeing move into the heap.
+ * A request mem_map has no room for falls back to the heap. A mapped
+ * block's header word holds the length of its mapping.
+ */
+#ifndef MAP_MIN
+#define MAP_MIN     (128 * 1024)
+#endif
+#ifndef MAP_MAX
+#define MAP_MAX     (32 * 1024 * 1024)
+#endif
+
+/*
+ * Requests of up to SLAB_MAX bytes are served from slab pages rather
+ * than boundary-tag blocks. A slab is one page-aligned allocated
+ * block holding objects of a single size class, with a descriptor
+ * at the start of the page whose bitmap replaces per-object headers.
+ * slabmap has one bit per heap page, set iff that page is a slab,
+ * so mm_free can tell a slab object from a block by address alone.
+ * Its bytes are updated atomically since that test runs unlocked in
+ * the threaded build.
+ */
+#ifndef SLAB_SHIFT
+#define SLAB_SHIFT  10
+#endif
+#define SLAB_PAGE   (1 << SLAB_SHIFT)
+#ifndef SLAB_MAX
+#define SLAB_MAX    64
+#endif
+#define NCLASSES    (SLAB_MAX / DSIZE)
+#define SLAB_WORDS  ((SLAB_PAGE / DSIZE + 63) / 64)
+
+static inline intptr_t MAX(intptr_t x, intptr_t y)
 {
     return x > y ? x : y;
 }
 
-static inline uint32_t PACK(uint32_t size, int alloc)
+static inline word_t PACK(word_t size, int prev_alloc, int alloc)
 {
-    return ((size) | (alloc & 0x1));
+    return ((size) | (prev_alloc ? PREV_ALLOC : 0) | (alloc & 0x1));
 }
 
-static inline uint32_t GET(void *p)
+/*
+ * The threaded build reads the header of a block it owns without
+ * heap_lock while another thread may be flipping its prev-alloc bit,
+ * so header words are accessed as (relaxed) atomics there.
+ */
+static inline word_t GET(void *p)
 { 
-    return  *(uint32_t *)p;
+#ifdef MM_THREADS
+    return __atomic_load_n((word_t *)p, __ATOMIC_RELAXED);
+#else
+    return  *(word_t *)p;
+#endif
 }
 
-static inline void PUT( void *p, uint32_t val)
+static inline void PUT( void *p, word_t val)
 {
-    *((uint32_t *)p) = val;
+#ifdef MM_THREADS
+    __atomic_store_n((word_t *)p, val, __ATOMIC_RELAXED);
+#else
+    *((word_t *)p) = val;
+#endif
 }
 
-static inline uint32_t GET_SIZE(void *p)
+static inline word_t GET_SIZE(void *p)
 { 
     return GET(p) & ~0x7;
 }
@@ -49,6 +265,11 @@ static inline int GET_ALLOC(void *p)
     return GET(p) & 0x1;
 }
 
+static inline int GET_PREV_ALLOC(void *p)
+{
+    return (GET(p) & PREV_ALLOC) != 0;
+}
+
 static inline void *HDRP(void *bp)
 {
     return ( (char *)bp) - WSIZE;
@@ -64,42 +285,355 @@ static inline void *NEXT_BLKP(void *bp)
     return  ((char *)(bp) + GET_SIZE(((char *)(bp) - WSIZE)));
 }
 
+/* only valid when the previous block is free and so has a footer */
 static inline void* PREV_BLKP(void *bp)
 {
     return  ((char *)(bp) - GET_SIZE(((char *)(bp) - DSIZE)));
 }
 
+static inline void SET_PREV_ALLOC(void *bp)
+{
+    PUT(HDRP(bp), GET(HDRP(bp)) | PREV_ALLOC);
+}
+
+static inline void CLR_PREV_ALLOC(void *bp)
+{
+    PUT(HDRP(bp), GET(HDRP(bp)) & ~PREV_ALLOC);
+}
+
+static inline int GET_GROWN(void *bp)
+{
+    return (GET(HDRP(bp)) & GROWN) != 0;
+}
+
+static inline void SET_GROWN(void *bp)
+{
+    PUT(HDRP(bp), GET(HDRP(bp)) | GROWN);
+}
+
+/* block size for a payload of size bytes: header plus payload, DSIZE aligned */
+static inline word_t ADJUST(word_t size)
+{
+    word_t asize = (size + WSIZE + DSIZE - 1) & ~(DSIZE - 1);
+    return asize < MINIMUM ? MINIMUM : asize;
+}
+
+/*
+ * request size a malloc of size is served as: sizeclass.h, made from
+ * profiled traces by "make classes", rounds up sizes whose freed
+ * blocks keep being passed over by requests slightly larger
+ */
+static inline word_t ROUND_CLASS(word_t size)
+{
+    int i;
+
+    for(i = 0; i < NROUNDS && size_rounds[i].from <= size; i++)
+    {
+        if(size_rounds[i].from == size)
+        {
+            return size_rounds[i].to;
+        }
+    }
+    return size;
+}
+
+/* room held back past asize for a block realloc keeps growing */
+static inline word_t SLACK(word_t asize)
+{
+    word_t slack = (uint64_t)asize * SLACK_NUM / SLACK_DEN;
+
+    return (slack < SLACK_CAP ? slack : SLACK_CAP) & ~(DSIZE - 1);
+}
+
+#if COMPACT_LINKS
+typedef struct freelist
+{
+    uint32_t prev;
+    uint32_t next;
+}freelist;
+#else
 typedef struct freelist
 {
     struct freelist *prev;
     struct freelist *next;
 }freelist;
+#endif
 
+typedef struct slab
+{
+    struct slab *prev;
+    struct slab *next;
+    uint32_t size;
+    uint32_t nobjs;
+    uint32_t nfree;
+    uint32_t pad;
+    uint64_t used[SLAB_WORDS];
+}__attribute__((aligned(DSIZE))) slab;  /* objects follow it aligned */
+
+/*
+ * An arena is an independent heap: its own free lists and slabs over
+ * its own segments of the memlib heap. top is the end of the arena's
+ * last segment, just past its epilogue. The plain build has a single
+ * arena. With MM_THREADS there are NARENAS, each behind its own lock,
+ * and ar is the one the calling thread currently works on. Segments
+ * of other arenas start on a fresh page, and arenamap records the
+ * owner of every page so a block can be handed back to its arena.
+ * Blocks freed by threads living in another arena are pushed onto
+ * its remote list without the lock: the low word of remote is the
+ * heap offset of the first block in DSIZE units, each linking to the next through
+ * its first payload word, and the high word is a tag bumped on every
+ * change so a stale compare-and-swap can never succeed (ABA).
+ */
+#ifdef MM_THREADS
+#ifndef NARENAS
+#define NARENAS     8
+#endif
+#else
+#define NARENAS     1
+#endif
+
+typedef struct arena
+{
+    freelist *bins[NBINS];
+    uint64_t binmap;
+    freelist *quick[NQUICK];
+    word_t quick_bytes;
+    slab *partial[NCLASSES];
+    char *top;
+    word_t chunk;
+    uint32_t mallocs;
+#ifdef MM_THREADS
+    pthread_mutex_t lock;
+    uint64_t remote;
+#endif
+}arena;
+
+static char *heap_lo;
+static char *map_lo, *map_hi;
+static word_t map_threshold;
 static void *start;
-static freelist *firstfree;
-static freelist *root;
+static arena arenas[NARENAS];
+static uint8_t *slabmap;
+static size_t npages;
+static size_t pages_used;  /* pages the heap has reached since the maps were clear */
+#ifdef MM_THREADS
+static __thread arena *ar;
+static pthread_mutex_t brk_lock = PTHREAD_MUTEX_INITIALIZER;
+static uint8_t *arenamap;
+#else
+static arena *const ar = arenas;
+#endif
 
-static void *extend_heap(uint32_t words);
+static int heap_init(void);
+static int page_maps(void);
+static void *heap_malloc(size_t size);
+static void *heap_alloc(size_t size, int *zero);
+static void *heap_calloc(size_t bytes);
+static size_t heap_malloc_batch(size_t size, size_t n, void **out);
+static void heap_free(void *bp);
+static size_t sort_blocks(void **ptrs, size_t n);
+static void sort_addrs(void **a, size_t n);
+static void heap_free_sorted(void **ptrs, size_t n);
+static void *heap_realloc(void *ptr, size_t size);
+static void *heap_memalign(size_t alignment, size_t size);
+static void *arena_sbrk(word_t size, int contiguous);
+static void *extend_heap(word_t words);
+static word_t grow_size(word_t asize);
 static void insert_to_free(freelist *bp);
 static void remove_from_free(freelist* bp);
-static void *find_fit(uint32_t asize);
-static void place(void *bp, uint32_t asize);
+static void *find_fit(word_t asize);
+static word_t place(void *bp, word_t asize);
+static void place_run(void *bp, word_t asize, size_t n, void **out);
 static void *coalesce(void *bp);
+static void free_block(void *bp);
+static inline word_t in_place(void *ptr);
+static void shrink(void *bp, word_t asize);
+static void consolidate(void);
+static void *map_alloc(word_t size);
+static void map_free(void *bp);
+static void *slab_alloc(word_t size);
+static void slab_free(void *p);
 static void pb(void *bp);
 static void pf(void);
 static void ph(void);
 
-int mm_init(void)
+#if COMPACT_LINKS
+static inline uint32_t TO_LINK(freelist *bp)
+{
+    return bp == NULL ? 0 : (uint32_t)((char *)bp - heap_lo);
+}
+
+static inline freelist *FROM_LINK(uint32_t off)
+{
+    return off == 0 ? NULL : (freelist *)(heap_lo + off);
+}
+#else
+static inline freelist *TO_LINK(freelist *bp)
+{
+    return bp;
+}
+
+static inline freelist *FROM_LINK(freelist *bp)
 {
-    firstfree = NULL;
+    return bp;
+}
+#endif
+
+static inline freelist *NEXT_FREE(freelist *bp)
+{
+    return FROM_LINK(bp->next);
+}
+
+static inline freelist *PREV_FREE(freelist *bp)
+{
+    return FROM_LINK(bp->prev);
+}
+
+static inline void SET_NEXT_FREE(freelist *bp, freelist *next)
+{
+    bp->next = TO_LINK(next);
+}
+
+static inline void SET_PREV_FREE(freelist *bp, freelist *prev)
+{
+    bp->prev = TO_LINK(prev);
+}
+
+static inline size_t PAGE_INDEX(void *p)
+{
+    return ((uintptr_t)p >> SLAB_SHIFT) - ((uintptr_t)heap_lo >> SLAB_SHIFT);
+}
+
+static inline int IS_MAPPED(void *p)
+{
+    return (char *)p >= map_lo && (char *)p <= map_hi;
+}
+
+static inline int IS_SLAB(void *p)
+{
+    size_t i = PAGE_INDEX(p);
+    return (__atomic_load_n(&slabmap[i >> 3], __ATOMIC_RELAXED) >> (i & 7)) & 1;
+}
+
+static inline slab *SLAB_OF(void *p)
+{
+    return (slab *)((uintptr_t)p & ~(uintptr_t)(SLAB_PAGE - 1));
+}
+
+#ifdef MM_THREADS
+static inline arena *ARENA_OF(void *p)
+{
+    return arenas + __atomic_load_n(&arenamap[PAGE_INDEX(p)], __ATOMIC_RELAXED);
+}
+#endif
+
+static inline int getbin(word_t size)
+{
+    int bin;
+
+    if(size < EXACT_BINS * DSIZE)
+    {
+        return size / DSIZE;
+    }
+    bin = 63 - __builtin_clzll(size) - __builtin_ctz(EXACT_BINS * DSIZE);
+    bin = bin_pow2[bin < (int)sizeof(bin_pow2) - 1 ? bin : (int)sizeof(bin_pow2) - 1];
+    while(bin + 1 < NBOUNDS && size >= bin_bounds[bin + 1])
+    {
+        bin++;
+    }
+    return EXACT_BINS + bin;
+}
+
+/* bytes of the one mapping that holds slabmap, then arenamap */
+static inline size_t maps_size(size_t pages)
+{
+#ifdef MM_THREADS
+    return pages / 8 + 1 + pages;
+#else
+    return pages / 8 + 1;
+#endif
+}
+
+/* clear the map entries of the first used pages, all a heap can have set */
+static void clear_maps(size_t used)
+{
+    memset(slabmap, 0, used / 8 + 1);
+#ifdef MM_THREADS
+    memset(arenamap, 0, used);
+#endif
+}
+
+/*
+ * page_maps - give slabmap and arenamap a clear entry for every page
+ *     of the heap memlib was set up with. They are reserved, not
+ *     allocated, so only the pages the heap reaches take memory, and
+ *     a later mm_init only clears the entries of those pages.
+ */
+static int page_maps(void)
+{
+    size_t pages = mem_heap_max() / SLAB_PAGE + 1;
+    void *maps;
+
+    if(pages == npages)
+    {
+        clear_maps(pages_used);
+        pages_used = 0;
+        return 0;
+    }
+    if(slabmap != NULL)
+    {
+        munmap(slabmap, maps_size(npages));
+        slabmap = NULL;
+        npages = 0;
+    }
+    maps = mmap(NULL, maps_size(pages), PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if(maps == MAP_FAILED)
+    {
+        return -1;
+    }
+    slabmap = maps;
+    npages = pages;
+    pages_used = 0;
+#ifdef MM_THREADS
+    arenamap = slabmap + pages / 8 + 1;
+#endif
+    return 0;
+}
+
+static int heap_init(void)
+{
+    int i;
+
+    for(i = 0; i < NARENAS; i++)
+    {
+        memset(arenas[i].bins, 0, sizeof(arenas[i].bins));
+        arenas[i].binmap = 0;
+        memset(arenas[i].quick, 0, sizeof(arenas[i].quick));
+        arenas[i].quick_bytes = 0;
+        memset(arenas[i].partial, 0, sizeof(arenas[i].partial));
+        arenas[i].top = NULL;
+        arenas[i].chunk = CHUNKSIZE;
+        arenas[i].mallocs = 0;
+    }
+    heap_lo = mem_heap_lo();
+    map_lo = mem_map_lo();
+    map_hi = mem_map_hi();
+    map_threshold = MAP_MIN;
+    if(page_maps() < 0)
+        return -1;
+#ifdef MM_THREADS
+    ar = arenas;
+#endif
 
     if((start = mem_sbrk(4*WSIZE)) == (void*) -1)
         return -1;
     
     PUT(start, 0);
-    PUT(start + (WSIZE), PACK(DSIZE, 1));
-    PUT(start + (2*WSIZE), PACK(DSIZE, 1));
-    PUT(start + (3*WSIZE), PACK(0,1));
+    PUT(start + (WSIZE), PACK(DSIZE, 1, 1));
+    PUT(start + (2*WSIZE), PACK(DSIZE, 1, 1));
+    PUT(start + (3*WSIZE), PACK(0, 1, 1));
+    ar->top = start + (4*WSIZE);
     start += (2*WSIZE);
     
     if(extend_heap(CHUNKSIZE/WSIZE) == NULL)
@@ -108,262 +642,1579 @@ int mm_init(void)
     return 0;
 }
 
-static void *extend_heap(uint32_t words) 
+static void *extend_heap(word_t words) 
 {
     void *bp;
-    uint32_t size;
+    word_t size;
     size = (words%2) ? (words+1) * WSIZE : words * WSIZE;
-    if((bp = mem_sbrk(size)) == (void*) -1)
+    if((bp = arena_sbrk(size, 0)) == NULL)
         return NULL;
     
-    PUT(HDRP(bp), PACK(size, 0));
-    PUT(FTRP(bp), PACK(size, 0));
-    PUT(HDRP(NEXT_BLKP(bp)), PACK(0,1));
+    /* the old epilogue header becomes ours, keep its prev-alloc bit */
+    PUT(HDRP(bp), PACK(size, GET_PREV_ALLOC(HDRP(bp)), 0) | ZEROED);
+    PUT(FTRP(bp), PACK(size, 0, 0));
+    PUT(HDRP(NEXT_BLKP(bp)), PACK(0, 0, 1));
 
     return coalesce(bp);
 }
 
-void *mm_malloc(uint32_t size)
+/* heap_sbrk - mem_sbrk, refusing to take the heap past HEAP_LIMIT */
+static inline void *heap_sbrk(word_t incr)
 {
-    uint32_t asize;
-    uint32_t extendsize;
-    void *bp;
-    
-    if(size == 0)
+    char *bp;
+
+    if(incr > HEAP_LIMIT - mem_heapsize() || (bp = mem_sbrk(incr)) == (void *)-1)
     {
-        return NULL;
+        return (void *)-1;
     }
-    else if(size == 448)
+    if(PAGE_INDEX(mem_heap_hi()) >= pages_used)
     {
-        size = 512;
+        pages_used = PAGE_INDEX(mem_heap_hi()) + 1;
     }
-    else if(size == 112)
+    return bp;
+}
+
+/*
+ * arena_sbrk - grow the current arena by size bytes at the break and
+ *     return the new space, which starts right after its epilogue;
+ *     with contiguous set, fail rather than start a new segment
+ */
+#ifdef MM_THREADS
+static void *arena_sbrk(word_t size, int contiguous)
+{
+    char *brk, *seg, *bp;
+    word_t pad, i;
+
+    pthread_mutex_lock(&brk_lock);
+    brk = (char *)mem_heap_hi() + 1;
+    seg = ar->top;
+    if(seg != brk && contiguous)
     {
-        size = 128;
+        pthread_mutex_unlock(&brk_lock);
+        return NULL;
     }
-    else if(size <= DSIZE)
+    if(seg != brk)
     {
-        size = 2*DSIZE;
+        /* someone else grew the heap last, start a fenced segment */
+        pad = -(uintptr_t)brk & (SLAB_PAGE - 1);
+        if((seg = heap_sbrk(pad + 4*WSIZE)) == (void*) -1)
+        {
+            pthread_mutex_unlock(&brk_lock);
+            return NULL;
+        }
+        seg += pad;
+        PUT(seg, 0);
+        PUT(seg + (WSIZE), PACK(DSIZE, 1, 1));
+        PUT(seg + (2*WSIZE), PACK(DSIZE, 1, 1));
+        PUT(seg + (3*WSIZE), PACK(0, 1, 1));
+        ar->top = seg + (4*WSIZE);
     }
-    else if((size%DSIZE) != 0)
+    if((bp = heap_sbrk(size)) == (void*) -1)
     {
-        uint32_t times = size/DSIZE;
-        size = (times+1)* DSIZE;
+        pthread_mutex_unlock(&brk_lock);
+        return NULL;
     }
-    asize = size + DSIZE;
-    if((bp = find_fit(asize)) != NULL)
+    ar->top = bp + size;
+    for(i = PAGE_INDEX(seg); i <= PAGE_INDEX(ar->top - 1); i++)
     {
-        place(bp, asize);
-        return bp;
+        __atomic_store_n(&arenamap[i], ar - arenas, __ATOMIC_RELAXED);
     }
+    pthread_mutex_unlock(&brk_lock);
+    return bp;
+}
+#else
+static void *arena_sbrk(word_t size, int contiguous)
+{
+    char *bp;
 
-    extendsize = MAX(asize, CHUNKSIZE);
-    if((bp = extend_heap(extendsize/WSIZE)) == NULL)
+    if((bp = heap_sbrk(size)) == (void*) -1)
         return NULL;
-
-    place(bp, asize);
+    ar->top = bp + size;
     return bp;
 }
+#endif
 
-static void *find_fit(uint32_t asize)
+/*
+ * grow_size - bytes to extend the heap by for a block of asize: what
+ *     a free block at the end of the heap does not already cover, or
+ *     the arena's chunk if that is more. Only growth the chunk covers
+ *     counts towards adapting it.
+ */
+static word_t grow_size(word_t asize)
 {
-    freelist* bp;
-    freelist* best = NULL;
-    uint32_t best_size = 2147483648;
-    for(bp = firstfree; bp != NULL; bp = bp->next)
+    word_t need = asize;
+
+    if(!GET_PREV_ALLOC(HDRP(ar->top)))
     {
-        if(GET_SIZE(HDRP(bp)) == asize)
-        {
-            return bp;
-        }
-        if(GET_SIZE(HDRP(bp)) < best_size && GET_SIZE(HDRP(bp)) > asize)
-        {
-            best = bp;
-            best_size = GET_SIZE(HDRP(best));
-        }
+        need -= GET_SIZE(ar->top - DSIZE);
     }
-    if(best_size == 2147483648)
+    if(need >= ar->chunk)
     {
-        return NULL;
+        return need;
     }
-    return best;
-}
-
-static void place(void *bp, uint32_t asize)
-{
-    uint32_t csize = GET_SIZE(HDRP(bp));
-
-    if((csize - asize) >= MINIMUM)
+    if(ar->mallocs < CHUNK_BURST)
     {
-        PUT(HDRP(bp), PACK(asize, 1));
-        PUT(FTRP(bp), PACK(asize, 1));
-        remove_from_free((freelist*)bp);
-
-        bp = NEXT_BLKP(bp);
-        PUT(HDRP(bp), PACK(csize - asize, 0));
-        PUT(FTRP(bp), PACK(csize - asize, 0));
-        insert_to_free((freelist*)bp);
+        ar->chunk = ar->chunk < CHUNK_MAX ? ar->chunk * 2 : CHUNK_MAX;
     }
-    else
+    else if(ar->chunk > CHUNKSIZE)
     {
-        PUT(HDRP(bp), PACK(csize, 1));
-        PUT(FTRP(bp), PACK(csize, 1));
-        remove_from_free((freelist*)bp);
+        ar->chunk /= 2;
     }
+    ar->mallocs = 0;
+    return ar->chunk;
 }
 
-static void remove_from_free(freelist* bp)
+static void *heap_malloc(size_t size)
 {
-    if(GET_SIZE(HDRP(bp)) == 0)
+    int zero;
+
+    return heap_alloc(size, &zero);
+}
+
+/*
+ * heap_alloc - malloc, also setting *zero if the block came out of a
+ *     ZEROED free block (or is mapped, which is all zero)
+ */
+static void *heap_alloc(size_t size, int *zero)
+{
+    word_t asize;
+    word_t extendsize;
+    void *bp;
+    
+    *zero = 0;
+    if(size == 0 || size > MAX_REQUEST)
     {
-        PUT(HDRP(bp), PACK(0,1));
-        return;
+        return NULL;
     }
-    if(bp->next == NULL && bp->prev == NULL)
+    else if(size <= SLAB_MAX)
     {
-        firstfree = NULL;
+        return slab_alloc(size);
     }
-    else if(bp->prev == NULL && bp->next != NULL)
+    else if(size >= __atomic_load_n(&map_threshold, __ATOMIC_RELAXED) &&
+            (bp = map_alloc(size)) != NULL)
     {
-        firstfree = bp->next;
-        firstfree->prev = NULL;
+        *zero = 1;
+        return bp;
+    }
+    ar->mallocs++;
+    asize = ADJUST(ROUND_CLASS(size));
+    if(asize <= QUICK_MAX && (bp = ar->quick[asize / DSIZE]) != NULL)
+    {
+        ar->quick[asize / DSIZE] = NEXT_FREE(bp);
+        ar->quick_bytes -= asize;
+        return bp;
     }
-    else if(bp->prev != NULL && bp->next == NULL)
+    if((bp = find_fit(asize)) == NULL && ar->quick_bytes != 0)
     {
-        bp->prev->next = NULL;
+        consolidate();
+        bp = find_fit(asize);
     }
-    else if(bp->prev != NULL && bp->next != NULL)
+    if(bp != NULL)
     {
-        bp->prev->next = bp->next;
-        bp->next->prev = bp->prev;
-        bp->prev = NULL;
-        bp->next = NULL;
+        *zero = place(bp, asize) != 0;
+        return bp;
     }
+
+    extendsize = grow_size(asize);
+    if((bp = extend_heap(extendsize/WSIZE)) == NULL)
+        return NULL;
+    /* a fresh segment does not reach the old free block at the end */
+    if(GET_SIZE(HDRP(bp)) < asize && (bp = extend_heap(asize/WSIZE)) == NULL)
+        return NULL;
+
+    *zero = place(bp, asize) != 0;
+    return bp;
 }
 
-static void insert_to_free(freelist *bp)
+/*
+ * heap_calloc - a zeroed block of bytes bytes. One carved out of a
+ *     ZEROED block only needs the links and footer it had while free
+ *     cleared; anything else gets a full memset.
+ */
+static void *heap_calloc(size_t bytes)
 {
-    if(GET_ALLOC(HDRP(bp)))
+    int zero;
+    void *bp;
+
+    if((bp = heap_alloc(bytes, &zero)) == NULL)
     {
-        return;
+        return NULL;
     }
-
-    if(firstfree == NULL)
+    if(!zero)
     {
-        firstfree = bp;
-        bp->next = NULL;
-        bp->prev = NULL;
+        memset(bp, 0, bytes);
     }
-    else if(firstfree != NULL)
+    else if(!IS_MAPPED(bp))
     {
-        bp->prev = firstfree->prev;
-        bp->next = firstfree;
-        firstfree->prev = bp;
-        firstfree = bp;
+        memset(bp, 0, sizeof(freelist));
+        PUT((char *)bp + GET_SIZE(HDRP(bp)) - DSIZE, 0);
     }
+    return bp;
 }
 
-void mm_free(void *bp)
+/*
+ * best_in_bin - smallest block on the list from bp that fits asize,
+ *     or in good-fit mode the best one before the search is cut off
+ */
+static freelist *best_in_bin(freelist *bp, word_t asize)
 {
-    if(bp == 0)
-        return;
-
-    uint32_t size = GET_SIZE(HDRP(bp));
-
-    PUT(HDRP(bp), PACK(size, 0));
-    PUT(FTRP(bp), PACK(size, 0));
+    freelist* best = NULL;
+    word_t best_size = (word_t)-1;
+    word_t good = asize + (uint64_t)asize * GOOD_PCT / 100;
+#if GOOD_PROBES
+    int probes = 0;
+#endif
 
-    coalesce(bp);
+    for(; bp != NULL; bp = NEXT_FREE(bp))
+    {
+        word_t size = GET_SIZE(HDRP(bp));
+        if(size < asize)
+        {
+            continue;
+        }
+        if(size <= good)
+        {
+            return bp;
+        }
+        if(size < best_size)
+        {
+            best = bp;
+            best_size = size;
+        }
+#if GOOD_PROBES
+        if(++probes == GOOD_PROBES)
+        {
+            break;
+        }
+#endif
+    }
+    return best;
 }
 
-static void *coalesce(void *bp)
+static void *find_fit(word_t asize)
 {
-    size_t prev_alloc = GET_ALLOC(FTRP(PREV_BLKP(bp)));
-    size_t next_alloc = GET_ALLOC(HDRP(NEXT_BLKP(bp)));
-    size_t size = GET_SIZE(HDRP(bp));
+    int bin = getbin(asize);
+    uint64_t avail;
+    freelist* bp;
 
-    if(prev_alloc && next_alloc)
+    if(bin >= EXACT_BINS)
     {
-        insert_to_free((freelist*)bp);
-        return bp;
+        if((bp = best_in_bin(ar->bins[bin], asize)) != NULL)
+        {
+            return bp;
+        }
     }
-    else if(prev_alloc && !next_alloc)
+    else if(ar->bins[bin] != NULL)
     {
-        size = size + GET_SIZE(HDRP(NEXT_BLKP(bp)));
-        remove_from_free((freelist*)NEXT_BLKP(bp));
-        PUT(HDRP(bp), PACK(size, 0));
-        PUT(FTRP(bp), PACK(size, 0));
-
-        insert_to_free((freelist*)bp);
-        return bp;
+        return ar->bins[bin];
     }
-    else if(!prev_alloc && next_alloc)
+
+    /* every block in a larger bin fits, take the smallest bin that has one */
+    avail = ar->binmap & ~((2ULL << bin) - 1);
+    if(avail == 0)
     {
-        size = size + GET_SIZE(HDRP(PREV_BLKP(bp)));
-        bp = PREV_BLKP(bp);
-        PUT(HDRP(bp), PACK(size, 0));
-        PUT(FTRP(bp), PACK(size, 0));
-        return bp;
+        return NULL;
     }
-    else if(!prev_alloc && !next_alloc)
+    bin = __builtin_ctzll(avail);
+    if(bin < EXACT_BINS)
     {
-        size = size + GET_SIZE(HDRP(PREV_BLKP(bp))) + GET_SIZE(FTRP(NEXT_BLKP(bp)));
-        remove_from_free((freelist*)NEXT_BLKP(bp));
-        remove_from_free((freelist*)PREV_BLKP(bp));
-
-        bp = PREV_BLKP(bp);
-        insert_to_free((freelist*)bp);
-        PUT(HDRP(bp), PACK(size, 0));
-        PUT(FTRP(bp), PACK(size, 0));
-        return bp;
+        return ar->bins[bin];
     }
-    printf("something bad happened!!!");
-    return bp;
+    return best_in_bin(ar->bins[bin], asize);
 }
 
-void *mm_realloc(void *ptr, uint32_t size)
+/*
+ * heap_malloc_batch - n mallocs of size bytes into out, returning how
+ *     many succeeded. Blocks on the quick list go first. The rest are
+ *     cut, as many at a time as fit, from the free block malloc would
+ *     pick for one of them, and what the free lists cannot hold comes
+ *     from a single heap extension. Slab and mapped sizes are plain
+ *     malloc loops.
+ */
+static size_t heap_malloc_batch(size_t size, size_t n, void **out)
 {
-    void *newp;
-    uint32_t copySize;
-
-    uint32_t next_alloc = GET_ALLOC(HDRP(NEXT_BLKP(ptr)));
+    word_t asize, need;
+    size_t i = 0, k;
+    void *bp;
 
-    uint32_t next_size = GET_SIZE(HDRP(NEXT_BLKP(ptr)));
-    
-    uint32_t curr_size = GET_SIZE(HDRP(ptr));
-    uint32_t combine_size = curr_size + next_size;
-    uint32_t asize = size + DSIZE;
-    
-    if(curr_size > asize)
+    if(size == 0 || size > MAX_REQUEST)
     {
-        return ptr;
+        return 0;
     }
-    
-    if(!next_alloc && combine_size >= asize)
+    if(size > SLAB_MAX && size < __atomic_load_n(&map_threshold, __ATOMIC_RELAXED))
     {
-        remove_from_free((freelist*)NEXT_BLKP(ptr));
-        PUT(HDRP(ptr), PACK(combine_size, 1));
-        PUT(FTRP(ptr), PACK(combine_size, 1));
-            
-        return ptr;
+        asize = ADJUST(ROUND_CLASS(size));
+        ar->mallocs += n;
+        if(asize <= QUICK_MAX)
+        {
+            for(; i < n && (bp = ar->quick[asize / DSIZE]) != NULL; i++)
+            {
+                ar->quick[asize / DSIZE] = NEXT_FREE(bp);
+                ar->quick_bytes -= asize;
+                out[i] = bp;
+            }
+        }
+        /* the parked blocks are freed for real once nothing else fits */
+        for(;;)
+        {
+            while(i < n && (bp = find_fit(asize)) != NULL)
+            {
+                k = GET_SIZE(HDRP(bp)) / asize;
+                k = k < n - i ? k : n - i;
+                place_run(bp, asize, k, out + i);
+                i += k;
+            }
+            if(i == n || ar->quick_bytes == 0)
+            {
+                break;
+            }
+            consolidate();
+        }
+        if(i < n && n - i <= MAX_REQUEST / asize)
+        {
+            need = (n - i) * asize;
+            if((bp = extend_heap(grow_size(need)/WSIZE)) != NULL &&
+               GET_SIZE(HDRP(bp)) < need)
+            {
+                bp = extend_heap(need/WSIZE);
+            }
+            if(bp != NULL)
+            {
+                place_run(bp, asize, n - i, out + i);
+                return n;
+            }
+        }
     }
+    for(; i < n && (out[i] = heap_malloc(size)) != NULL; i++)
+        ;
+    return i;
+}
 
-    newp = mm_malloc(size);
-    if (newp == NULL)
+/*
+ * place_run - allocate n blocks of asize bytes, one after the other,
+ *     from the start of free block bp, storing their payloads in out
+ */
+static void place_run(void *bp, word_t asize, size_t n, void **out)
+{
+    word_t csize = GET_SIZE(HDRP(bp));
+    word_t rest = csize - n * asize;
+    word_t zero = GET(HDRP(bp)) & ZEROED;
+    char *p = bp;
+    size_t i;
+
+    remove_from_free((freelist*)bp);
+    PUT(HDRP(p), PACK(asize, GET_PREV_ALLOC(HDRP(p)), 1));
+    out[0] = p;
+    for(i = 1; i < n; i++)
     {
-        printf("ERROR: mm_malloc failed in mm_realloc\n");
-        exit(1);
+        p += asize;
+        PUT(HDRP(p), PACK(asize, 1, 1));
+        out[i] = p;
     }
-    copySize = GET_SIZE(HDRP(ptr));
+    if(rest >= MINIMUM)
+    {
+        p += asize;
+        PUT(HDRP(p), PACK(rest, 1, 0) | zero);
+        PUT(FTRP(p), PACK(rest, 1, 0));
+        insert_to_free((freelist*)p);
+    }
+    else
+    {
+        /* the last block takes the sliver too small to be free */
+        PUT(HDRP(p), PACK(asize + rest, GET_PREV_ALLOC(HDRP(p)), 1));
+        SET_PREV_ALLOC(NEXT_BLKP(p));
+    }
+}
+
+/* place - allocate asize bytes of free block bp; returns its ZEROED bit */
+static word_t place(void *bp, word_t asize)
+{
+    word_t csize = GET_SIZE(HDRP(bp));
+    int prev_alloc = GET_PREV_ALLOC(HDRP(bp));
+    word_t zero = GET(HDRP(bp)) & ZEROED;
+
+    remove_from_free((freelist*)bp);
+    if((csize - asize) >= MINIMUM)
+    {
+        PUT(HDRP(bp), PACK(asize, prev_alloc, 1));
+
+        bp = NEXT_BLKP(bp);
+        PUT(HDRP(bp), PACK(csize - asize, 1, 0) | zero);
+        PUT(FTRP(bp), PACK(csize - asize, 1, 0));
+        insert_to_free((freelist*)bp);
+    }
+    else
+    {
+        PUT(HDRP(bp), PACK(csize, prev_alloc, 1));
+        SET_PREV_ALLOC(NEXT_BLKP(bp));
+    }
+    return zero;
+}
+
+static void remove_from_free(freelist* bp)
+{
+    int bin = getbin(GET_SIZE(HDRP(bp)));
+
+    freelist *prev = PREV_FREE(bp);
+    freelist *next = NEXT_FREE(bp);
+
+    if(prev == NULL)
+    {
+        ar->bins[bin] = next;
+        if(next == NULL)
+        {
+            ar->binmap &= ~(1ULL << bin);
+        }
+    }
+    else
+    {
+        SET_NEXT_FREE(prev, next);
+    }
+    if(next != NULL)
+    {
+        SET_PREV_FREE(next, prev);
+    }
+}
+
+static void insert_to_free(freelist *bp)
+{
+    int bin = getbin(GET_SIZE(HDRP(bp)));
+
+    SET_PREV_FREE(bp, NULL);
+    SET_NEXT_FREE(bp, ar->bins[bin]);
+    if(ar->bins[bin] != NULL)
+    {
+        SET_PREV_FREE(ar->bins[bin], bp);
+    }
+    ar->bins[bin] = bp;
+    ar->binmap |= 1ULL << bin;
+}
+
+static void heap_free(void *bp)
+{
+    word_t size;
+
+    if(bp == 0)
+        return;
+
+    if(IS_MAPPED(bp))
+    {
+        map_free(bp);
+        return;
+    }
+    if(IS_SLAB(bp))
+    {
+        slab_free(bp);
+        return;
+    }
+
+    size = GET_SIZE(HDRP(bp));
+    if(size <= QUICK_MAX)
+    {
+        PUT(HDRP(bp), GET(HDRP(bp)) & ~GROWN);
+        SET_NEXT_FREE(bp, ar->quick[size / DSIZE]);
+        ar->quick[size / DSIZE] = bp;
+        if((ar->quick_bytes += size) > QUICK_LIMIT)
+        {
+            consolidate();
+        }
+        return;
+    }
+    free_block(bp);
+}
+
+/* start loading the header the walk of ptrs reaches BATCH_AHEAD steps after k */
+static inline void PREFETCH_AHEAD(void **ptrs, size_t k, size_t n)
+{
+    if(k + BATCH_AHEAD < n)
+    {
+        __builtin_prefetch(HDRP(ptrs[k + BATCH_AHEAD]));
+    }
+}
+
+/*
+ * sort_addrs - sort n, at most BATCH_SORT, block pointers by address
+ *     with an LSD radix sort on their DSIZE-unit offsets from the
+ *     lowest, a byte per pass and only as many passes as the spread
+ *     needs. It has no compares to mispredict on shuffled input.
+ */
+static void sort_addrs(void **a, size_t n)
+{
+    void *tmp[BATCH_SORT];
+    void **from = a, **to = tmp, **t;
+    uintptr_t lo = UINTPTR_MAX, hi = 0;
+    size_t count[257];
+    size_t i;
+    int shift;
+
+    for(i = 0; i < n; i++)
+    {
+        lo = (uintptr_t)a[i] < lo ? (uintptr_t)a[i] : lo;
+        hi = (uintptr_t)a[i] > hi ? (uintptr_t)a[i] : hi;
+    }
+    for(shift = 0; shift == 0 || (shift < 64 && ((hi - lo) / DSIZE >> shift) != 0); shift += 8)
+    {
+        memset(count, 0, sizeof(count));
+        for(i = 0; i < n; i++)
+        {
+            count[(((uintptr_t)from[i] - lo) / DSIZE >> shift & 255) + 1]++;
+        }
+        for(i = 1; i < 257; i++)
+        {
+            count[i] += count[i - 1];
+        }
+        for(i = 0; i < n; i++)
+        {
+            to[count[((uintptr_t)from[i] - lo) / DSIZE >> shift & 255]++] = from[i];
+        }
+        t = from;
+        from = to;
+        to = t;
+    }
+    if(from != a)
+    {
+        memcpy(a, from, n * sizeof(void *));
+    }
+}
+
+/*
+ * sort_blocks - unmap the mapped blocks among ptrs, at most BATCH_SORT,
+ *     drop them and any NULLs, and sort the rest by address; returns
+ *     how many are left
+ */
+static size_t sort_blocks(void **ptrs, size_t n)
+{
+    size_t i, m = 0;
+    int sorted = 1;
+
+    for(i = 0; i < n; i++)
+    {
+        if(ptrs[i] == NULL)
+        {
+            continue;
+        }
+        if(IS_MAPPED(ptrs[i]))
+        {
+            map_free(ptrs[i]);
+            continue;
+        }
+        ptrs[m++] = ptrs[i];
+        sorted &= m == 1 || ptrs[m - 2] < ptrs[m - 1];
+    }
+    if(!sorted)
+    {
+        sort_addrs(ptrs, m);
+    }
+    return m;
+}
+
+/*
+ * heap_free_sorted - free the heap blocks and slab objects ptrs holds
+ *     in address order. A run of blocks that follow one another turns
+ *     into a single free block with one coalesce; a block on its own
+ *     is freed as usual.
+ */
+static void heap_free_sorted(void **ptrs, size_t n)
+{
+    size_t i, j;
+    char *bp, *end;
+
+    for(i = 0; i < BATCH_AHEAD && i < n; i++)
+    {
+        __builtin_prefetch(HDRP(ptrs[i]));
+    }
+    for(i = 0; i < n; i = j)
+    {
+        bp = ptrs[i];
+        PREFETCH_AHEAD(ptrs, i, n);
+        j = i + 1;
+        if(IS_SLAB(bp))
+        {
+            slab_free(bp);
+            continue;
+        }
+        for(end = NEXT_BLKP(bp); j < n && ptrs[j] == end; j++)
+        {
+            PREFETCH_AHEAD(ptrs, j, n);
+            end = NEXT_BLKP(end);
+        }
+        if(j == i + 1)
+        {
+            heap_free(bp);
+            continue;
+        }
+        PUT(HDRP(bp), PACK(end - bp, GET_PREV_ALLOC(HDRP(bp)), 1));
+        free_block(bp);
+    }
+}
+
+/*
+ * consolidate - free and coalesce every block parked on the quick lists
+ */
+static void consolidate(void)
+{
+    freelist *bp;
+    int i;
+
+    for(i = 0; i < NQUICK; i++)
+    {
+        while((bp = ar->quick[i]) != NULL)
+        {
+            ar->quick[i] = NEXT_FREE(bp);
+            free_block(bp);
+        }
+    }
+    ar->quick_bytes = 0;
+}
+
+static void free_block(void *bp)
+{
+    word_t size = GET_SIZE(HDRP(bp));
+
+    PUT(HDRP(bp), PACK(size, GET_PREV_ALLOC(HDRP(bp)), 0));
+    PUT(FTRP(bp), PACK(size, 0, 0));
+    CLR_PREV_ALLOC(NEXT_BLKP(bp));
+
+    coalesce(bp);
+}
+
+/*
+ * coalesce - merge free block bp with free neighbours. The result is
+ *     ZEROED only if every part was, and then the tags and links that
+ *     end up inside it are cleared.
+ */
+static void *coalesce(void *bp)
+{
+    size_t prev_alloc = GET_PREV_ALLOC(HDRP(bp));
+    size_t next_alloc = GET_ALLOC(HDRP(NEXT_BLKP(bp)));
+    size_t size = GET_SIZE(HDRP(bp));
+    word_t zero = GET(HDRP(bp)) & ZEROED;
+    char *next = NEXT_BLKP(bp);
+
+    if(!next_alloc)
+    {
+        size = size + GET_SIZE(HDRP(next));
+        zero &= GET(HDRP(next));
+        remove_from_free((freelist*)next);
+    }
+    if(!prev_alloc)
+    {
+        char *prev = PREV_BLKP(bp);
+        size = size + GET_SIZE(HDRP(prev));
+        zero &= GET(HDRP(prev));
+        remove_from_free((freelist*)prev);
+        if(zero)
+        {
+            memset((char *)bp - DSIZE, 0, DSIZE + sizeof(freelist));
+        }
+        bp = prev;
+    }
+    if(!next_alloc && zero)
+    {
+        memset(next - DSIZE, 0, DSIZE + sizeof(freelist));
+    }
+    PUT(HDRP(bp), PACK(size, 1, 0) | zero);
+    PUT(FTRP(bp), PACK(size, 1, 0));
+    insert_to_free((freelist*)bp);
+    return bp;
+}
+
+static void *heap_realloc(void *ptr, size_t size)
+{
+    void *newp;
+    word_t copySize;
+
+    if(size > MAX_REQUEST)
+    {
+        return NULL;
+    }
+    if(IS_MAPPED(ptr))
+    {
+        /* stays put while it fits and would still be mapped */
+        copySize = GET_SIZE(HDRP(ptr)) - DSIZE;
+        if(size <= copySize &&
+           size >= __atomic_load_n(&map_threshold, __ATOMIC_RELAXED))
+        {
+            return ptr;
+        }
+        if((newp = heap_malloc(size)) == NULL)
+        {
+            printf("ERROR: mm_malloc failed in mm_realloc\n");
+            exit(1);
+        }
+        memcpy(newp, ptr, size < copySize ? size : copySize);
+        map_free(ptr);
+        return newp;
+    }
+    if(IS_SLAB(ptr))
+    {
+        copySize = SLAB_OF(ptr)->size;
+        if(size <= copySize && size > copySize - DSIZE)
+        {
+            return ptr;
+        }
+        if((newp = heap_malloc(size)) == NULL)
+        {
+            printf("ERROR: mm_malloc failed in mm_realloc\n");
+            exit(1);
+        }
+        memcpy(newp, ptr, size < copySize ? size : copySize);
+        slab_free(ptr);
+        return newp;
+    }
+
+    word_t curr_size = GET_SIZE(HDRP(ptr));
+    word_t asize = ADJUST(size);
+    
+    if(curr_size > asize)
+    {
+        /* a block realloc has been growing keeps its reservation */
+        if(GET_GROWN(ptr))
+        {
+            asize += SLACK(asize);
+        }
+        if(curr_size >= asize + MINIMUM)
+        {
+            shrink(ptr, asize);
+        }
+        return ptr;
+    }
+
+    /* parked blocks next door may be all that stops growing in place */
+    if(ar->quick_bytes != 0 && in_place(ptr) < asize)
+    {
+        consolidate();
+    }
+
+    word_t next_alloc = GET_ALLOC(HDRP(NEXT_BLKP(ptr)));
+
+    word_t next_size = GET_SIZE(HDRP(NEXT_BLKP(ptr)));
+    
+    word_t combine_size = curr_size + next_size;
+    word_t merged;
+    
+    if(!next_alloc && combine_size >= asize)
+    {
+        remove_from_free((freelist*)NEXT_BLKP(ptr));
+        PUT(HDRP(ptr), PACK(combine_size, GET_PREV_ALLOC(HDRP(ptr)), 1) | GROWN);
+        SET_PREV_ALLOC(NEXT_BLKP(ptr));
+            
+        return ptr;
+    }
+
+    /* take the free block before, and the one after if it is free too */
+    if(!GET_PREV_ALLOC(HDRP(ptr)) && (merged = in_place(ptr)) >= asize)
+    {
+        newp = PREV_BLKP(ptr);
+        remove_from_free((freelist*)newp);
+        if(!next_alloc)
+        {
+            remove_from_free((freelist*)NEXT_BLKP(ptr));
+        }
+        memmove(newp, ptr, curr_size - WSIZE);
+        PUT(HDRP(newp), PACK(merged, GET_PREV_ALLOC(HDRP(newp)), 1) | GROWN);
+        SET_PREV_ALLOC(NEXT_BLKP(newp));
+
+        return newp;
+    }
+
+    /* the last block, or the one before a free last block, just gets
+       the missing bytes from the break with no copy at all */
+    word_t end_size = next_alloc ? curr_size : curr_size + next_size;
+
+    if((char *)ptr + end_size == ar->top &&
+       arena_sbrk(asize - end_size, 1) != NULL)
+    {
+        if(!next_alloc)
+        {
+            remove_from_free((freelist*)NEXT_BLKP(ptr));
+        }
+        PUT(HDRP(ptr), PACK(asize, GET_PREV_ALLOC(HDRP(ptr)), 1) | GROWN);
+        PUT(HDRP(NEXT_BLKP(ptr)), PACK(0, 1, 1));
+
+        return ptr;
+    }
+
+    newp = NULL;
+    if(GET_GROWN(ptr) && (newp = find_fit(asize + SLACK(asize))) != NULL)
+    {
+        place(newp, asize + SLACK(asize));
+    }
+    if(newp == NULL && (newp = heap_malloc(size)) == NULL)
+    {
+        printf("ERROR: mm_malloc failed in mm_realloc\n");
+        exit(1);
+    }
+    if(!IS_MAPPED(newp) && !IS_SLAB(newp))
+    {
+        SET_GROWN(newp);
+    }
+    copySize = curr_size - WSIZE;
     if(size < copySize)
     {
-        copySize = size;
+        copySize = size;
+    }
+    memcpy(newp, ptr, copySize);
+    heap_free(ptr);
+    return newp;
+}
+
+/*
+ * shrink - cut allocated block bp down to asize bytes and free the
+ *     tail, merging it with a free block after it
+ */
+static void shrink(void *bp, word_t asize)
+{
+    word_t csize = GET_SIZE(HDRP(bp));
+    word_t grown = GET(HDRP(bp)) & GROWN;
+
+    PUT(HDRP(bp), PACK(asize, GET_PREV_ALLOC(HDRP(bp)), 1) | grown);
+    bp = NEXT_BLKP(bp);
+    PUT(HDRP(bp), PACK(csize - asize, 1, 1));
+    free_block(bp);
+}
+
+/*
+ * in_place - size ptr's block would have after taking in whichever of
+ *     its neighbours are free
+ */
+static inline word_t in_place(void *ptr)
+{
+    word_t size = GET_SIZE(HDRP(ptr));
+
+    if(!GET_ALLOC(HDRP(NEXT_BLKP(ptr))))
+    {
+        size += GET_SIZE(HDRP(NEXT_BLKP(ptr)));
+    }
+    if(!GET_PREV_ALLOC(HDRP(ptr)))
+    {
+        size += GET_SIZE(HDRP(PREV_BLKP(ptr)));
+    }
+    return size;
+}
+
+/*
+ * align_in - first payload address in free block bp that is aligned
+ *     to align and leaves either no gap or a whole free block below it
+ */
+static inline char *align_in(void *bp, word_t align)
+{
+    uintptr_t pg = ((uintptr_t)bp + align - 1) & ~(uintptr_t)(align - 1);
+
+    if(pg != (uintptr_t)bp && pg - (uintptr_t)bp < MINIMUM)
+    {
+        pg = ((uintptr_t)bp + MINIMUM + align - 1) & ~(uintptr_t)(align - 1);
+    }
+    return (char *)pg;
+}
+
+/*
+ * aligned_fit - find a free block that can hold an asize block whose
+ *     payload is aligned to align, and that payload address
+ */
+static freelist *aligned_fit(word_t align, word_t asize, char **pgp)
+{
+    uint64_t avail = ar->binmap & ~((1ULL << getbin(asize)) - 1);
+    freelist *bp;
+    char *pg;
+
+    while(avail != 0)
+    {
+        int bin = __builtin_ctzll(avail);
+        for(bp = ar->bins[bin]; bp != NULL; bp = NEXT_FREE(bp))
+        {
+            pg = align_in(bp, align);
+            if(pg + asize <= (char *)bp + GET_SIZE(HDRP(bp)))
+            {
+                *pgp = pg;
+                return bp;
+            }
+        }
+        avail &= avail - 1;
+    }
+    return NULL;
+}
+
+/*
+ * place_aligned - allocate asize bytes with payload pg out of free
+ *     block bp, returning the leading and trailing fragments to the
+ *     free lists
+ */
+static void place_aligned(void *bp, char *pg, word_t asize)
+{
+    word_t csize = GET_SIZE(HDRP(bp));
+    word_t gap = pg - (char *)bp;
+    int prev_alloc = GET_PREV_ALLOC(HDRP(bp));
+    word_t zero = GET(HDRP(bp)) & ZEROED;
+
+    remove_from_free((freelist*)bp);
+    if(gap != 0)
+    {
+        PUT(HDRP(bp), PACK(gap, prev_alloc, 0) | zero);
+        PUT(FTRP(bp), PACK(gap, prev_alloc, 0));
+        insert_to_free((freelist*)bp);
+        prev_alloc = 0;
+        csize -= gap;
+    }
+    if((csize - asize) >= MINIMUM)
+    {
+        PUT(HDRP(pg), PACK(asize, prev_alloc, 1));
+        bp = NEXT_BLKP(pg);
+        PUT(HDRP(bp), PACK(csize - asize, 1, 0) | zero);
+        PUT(FTRP(bp), PACK(csize - asize, 1, 0));
+        insert_to_free((freelist*)bp);
+    }
+    else
+    {
+        PUT(HDRP(pg), PACK(csize, prev_alloc, 1));
+        SET_PREV_ALLOC(NEXT_BLKP(pg));
+    }
+}
+
+/*
+ * aligned_block - allocate an asize block with payload aligned to
+ *     align, from the free lists if possible and otherwise by growing
+ *     the heap just far enough past the wilderness block
+ */
+static void *aligned_block(word_t align, word_t asize)
+{
+    char *top, *pg;
+    void *bp;
+
+    if((bp = aligned_fit(align, asize, &pg)) == NULL && ar->quick_bytes != 0)
+    {
+        consolidate();
+        bp = aligned_fit(align, asize, &pg);
+    }
+    if(bp != NULL)
+    {
+        place_aligned(bp, pg, asize);
+        return pg;
+    }
+
+    /* only short if another arena took the break, then go again */
+    do
+    {
+        top = ar->top;
+        bp = top;
+        if(!GET_PREV_ALLOC(HDRP(top)))
+        {
+            bp = PREV_BLKP(top);
+        }
+        pg = align_in(bp, align);
+        if((bp = extend_heap(MAX(pg + asize - top, MINIMUM) / WSIZE)) == NULL)
+            return NULL;
+        pg = align_in(bp, align);
+    }while(pg + asize > (char *)bp + GET_SIZE(HDRP(bp)));
+
+    place_aligned(bp, pg, asize);
+    return pg;
+}
+
+/*
+ * heap_memalign - a block of size bytes with its payload aligned to
+ *     alignment, a power of two. Alignments every payload has anyway
+ *     are plain mallocs; larger ones are carved out of a free block
+ *     or the end of the heap by aligned_block, never from a slab or
+ *     a mapping.
+ */
+static void *heap_memalign(size_t alignment, size_t size)
+{
+    if(alignment == 0 || (alignment & (alignment - 1)) != 0 ||
+       alignment > MAX_REQUEST || size > MAX_REQUEST)
+    {
+        return NULL;
+    }
+    if(alignment <= DSIZE)
+    {
+        return heap_malloc(size);
+    }
+    if(size == 0)
+    {
+        return NULL;
+    }
+    return aligned_block(alignment, ADJUST(size));
+}
+
+/*
+ * map_alloc - a block of size bytes in a mapping of its own
+ */
+static void *map_alloc(word_t size)
+{
+    word_t len;
+    char *p;
+
+    if(size > MAX_MAP - DSIZE)
+    {
+        return NULL;
+    }
+    len = (size + DSIZE + MAP_PAGE - 1) & ~(MAP_PAGE - 1);
+#ifdef MM_THREADS
+    pthread_mutex_lock(&brk_lock);
+#endif
+    p = mem_map(len);
+#ifdef MM_THREADS
+    pthread_mutex_unlock(&brk_lock);
+#endif
+    if(p == (void*) -1)
+    {
+        return NULL;
+    }
+    PUT(p + WSIZE, PACK(len, 1, 1));
+    return p + DSIZE;
+}
+
+/*
+ * map_free - unmap a mapped block, raising the threshold to its size
+ */
+static void map_free(void *bp)
+{
+    word_t len = GET_SIZE(HDRP(bp));
+
+#ifdef MM_THREADS
+    pthread_mutex_lock(&brk_lock);
+#endif
+    mem_unmap((char *)bp - DSIZE, len);
+#ifdef MM_THREADS
+    pthread_mutex_unlock(&brk_lock);
+#endif
+    if(len > __atomic_load_n(&map_threshold, __ATOMIC_RELAXED) && len <= MAP_MAX)
+    {
+        __atomic_store_n(&map_threshold, len, __ATOMIC_RELAXED);
     }
-    memcpy(newp, ptr, copySize);
-    mm_free(ptr);
+}
+
+/*
+ * new_slab - set up a slab page for size class cls
+ */
+static slab *new_slab(int cls)
+{
+    slab *s;
+    size_t i;
+
+    if((s = aligned_block(SLAB_PAGE, SLAB_PAGE)) == NULL)
+        return NULL;
+
+    memset(s, 0, sizeof(slab));
+    s->size = (cls + 1) * DSIZE;
+    s->nobjs = (SLAB_PAGE - WSIZE - sizeof(slab)) / s->size;
+    s->nfree = s->nobjs;
+    for(i = s->nobjs; i < 64 * SLAB_WORDS; i++)
+    {
+        s->used[i / 64] |= 1ULL << (i % 64);
+    }
+
+    i = PAGE_INDEX(s);
+    __atomic_fetch_or(&slabmap[i >> 3], 1 << (i & 7), __ATOMIC_RELAXED);
+    s->next = ar->partial[cls];
+    if(ar->partial[cls] != NULL)
+    {
+        ar->partial[cls]->prev = s;
+    }
+    ar->partial[cls] = s;
+    return s;
+}
+
+static void unlink_slab(slab *s, int cls)
+{
+    if(s->prev == NULL)
+        ar->partial[cls] = s->next;
+    else
+        s->prev->next = s->next;
+    if(s->next != NULL)
+        s->next->prev = s->prev;
+    s->prev = NULL;
+    s->next = NULL;
+}
+
+static void *slab_alloc(word_t size)
+{
+    int cls = (size - 1) / DSIZE;
+    slab *s = ar->partial[cls];
+    int i, bit;
+
+    if(s == NULL && (s = new_slab(cls)) == NULL)
+    {
+        return NULL;
+    }
+
+    for(i = 0; ~s->used[i] == 0; i++)
+        ;
+    bit = __builtin_ctzll(~s->used[i]);
+    s->used[i] |= 1ULL << bit;
+    if(--s->nfree == 0)
+    {
+        unlink_slab(s, cls);
+    }
+    return (char *)(s + 1) + (i * 64 + bit) * s->size;
+}
+
+static void slab_free(void *p)
+{
+    slab *s = SLAB_OF(p);
+    int cls = s->size / DSIZE - 1;
+    uint32_t idx = ((char *)p - (char *)(s + 1)) / s->size;
+    size_t i;
+
+    s->used[idx / 64] &= ~(1ULL << (idx % 64));
+    if(s->nfree++ == 0)
+    {
+        s->next = ar->partial[cls];
+        if(ar->partial[cls] != NULL)
+        {
+            ar->partial[cls]->prev = s;
+        }
+        ar->partial[cls] = s;
+    }
+
+    /* hand empty slabs back to the heap, but keep the last one around */
+    if(s->nfree == s->nobjs && (ar->partial[cls] != s || s->next != NULL))
+    {
+        unlink_slab(s, cls);
+        i = PAGE_INDEX(s);
+        __atomic_fetch_and(&slabmap[i >> 3], ~(1 << (i & 7)), __ATOMIC_RELAXED);
+        free_block(s);
+    }
+}
+
+/*
+ * Public entry points. A plain build calls straight into the heap.
+ * With MM_THREADS each thread is handed a home arena round-robin and
+ * allocates there, moving to whichever arena is free when its home
+ * is busy. Frees and reallocs go back to the arena that owns the
+ * block; a free from outside that arena goes on its remote list,
+ * which is drained the next time the arena is locked to allocate.
+ * On top of that each thread keeps a cache of up to TC_COUNT freed
+ * blocks per size class for payloads of up to TC_MAX bytes, so most
+ * malloc/free pairs never touch shared state. Cached blocks stay
+ * allocated as far as their arena is concerned. A miss refills
+ * TC_BATCH blocks under one lock and a full class flushes TC_BATCH
+ * of them back the same way. heap_gen moves on with every mm_init,
+ * which tells each thread that whatever it has cached belongs to a
+ * heap that is gone.
+ */
+#ifdef MM_THREADS
+
+#ifndef TC_MAX
+#define TC_MAX      256
+#endif
+#ifndef TC_COUNT
+#define TC_COUNT    16
+#endif
+#define TC_CLASSES  (TC_MAX / DSIZE)
+#define TC_BATCH    (TC_COUNT / 2)
+
+typedef struct tcache
+{
+    unsigned gen;
+    uint32_t count[TC_CLASSES];
+    void *blocks[TC_CLASSES][TC_COUNT];
+}tcache;
+
+static pthread_once_t arena_once = PTHREAD_ONCE_INIT;
+static pthread_key_t tc_key;
+static unsigned heap_gen = 1;
+static unsigned next_arena;
+static __thread arena *home;
+static __thread tcache tc;
+
+/* payload bytes usable in an allocated block or slab object */
+static inline word_t usable_size(void *bp)
+{
+    return IS_SLAB(bp) ? SLAB_OF(bp)->size : GET_SIZE(HDRP(bp)) - WSIZE;
+}
+
+/* remote_free - queue bp on arena a for its next allocation */
+static void remote_free(arena *a, void *bp)
+{
+    uint64_t old = __atomic_load_n(&a->remote, __ATOMIC_RELAXED);
+    uint64_t new;
+
+    do
+    {
+        PUT(bp, (uint32_t)old);
+        new = ((old >> 32) + 1) << 32 | (uint32_t)(((char *)bp - heap_lo) / DSIZE);
+    }while(!__atomic_compare_exchange_n(&a->remote, &old, new, 1,
+                                        __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+}
+
+/* remote_drain - free every block other threads queued on ar */
+static void remote_drain(void)
+{
+    uint64_t old = __atomic_load_n(&ar->remote, __ATOMIC_RELAXED);
+    uint32_t off;
+    void *bp;
+
+    do
+    {
+        if((uint32_t)old == 0)
+            return;
+    }while(!__atomic_compare_exchange_n(&ar->remote, &old, ((old >> 32) + 1) << 32, 1,
+                                        __ATOMIC_ACQUIRE, __ATOMIC_RELAXED));
+
+    for(off = (uint32_t)old; off != 0; )
+    {
+        bp = heap_lo + (size_t)off * DSIZE;
+        off = GET(bp);
+        heap_free(bp);
+    }
+}
+
+/*
+ * arena_lock - lock an arena to allocate from and make it current;
+ *     NULL if a fresh arena cannot get its first segment
+ */
+static arena *arena_lock(void)
+{
+    arena *a;
+    int i;
+
+    if(home == NULL)
+    {
+        home = arenas + __atomic_fetch_add(&next_arena, 1, __ATOMIC_RELAXED) % NARENAS;
+    }
+    if(pthread_mutex_trylock(&home->lock) != 0)
+    {
+        for(i = 1; i < NARENAS; i++)
+        {
+            a = arenas + (home - arenas + i) % NARENAS;
+            if(pthread_mutex_trylock(&a->lock) == 0)
+            {
+                home = a;
+                break;
+            }
+        }
+        if(i == NARENAS)
+        {
+            pthread_mutex_lock(&home->lock);
+        }
+    }
+    ar = home;
+    if(ar->top == NULL && extend_heap(CHUNKSIZE/WSIZE) == NULL)
+    {
+        pthread_mutex_unlock(&ar->lock);
+        return NULL;
+    }
+    remote_drain();
+    return ar;
+}
+
+/* lock the arena that owns bp and make it current */
+static arena *owner_lock(void *bp)
+{
+    ar = ARENA_OF(bp);
+    pthread_mutex_lock(&ar->lock);
+    return ar;
+}
+
+/* give back all but keep of the class c blocks, locking home at most once */
+static void tc_flush(tcache *t, int c, uint32_t keep)
+{
+    arena *locked = NULL;
+    void *bp;
+
+    while(t->count[c] > keep)
+    {
+        bp = t->blocks[c][--t->count[c]];
+        if(ARENA_OF(bp) != home)
+        {
+            remote_free(ARENA_OF(bp), bp);
+            continue;
+        }
+        if(locked == NULL)
+        {
+            locked = owner_lock(bp);
+        }
+        heap_free(bp);
+    }
+    if(locked != NULL)
+    {
+        pthread_mutex_unlock(&locked->lock);
+    }
+}
+
+/* thread exit hands the cache back so its blocks are not lost */
+static void tc_exit(void *arg)
+{
+    tcache *t = arg;
+    int c;
+
+    if(t->gen == __atomic_load_n(&heap_gen, __ATOMIC_ACQUIRE))
+    {
+        for(c = 0; c < TC_CLASSES; c++)
+        {
+            tc_flush(t, c, 0);
+        }
+    }
+}
+
+static void arena_setup(void)
+{
+    int i;
+
+    for(i = 0; i < NARENAS; i++)
+    {
+        pthread_mutex_init(&arenas[i].lock, NULL);
+    }
+    pthread_key_create(&tc_key, tc_exit);
+}
+
+/* drop a cache left over from before the last mm_init */
+static inline void tc_check(void)
+{
+    unsigned gen = __atomic_load_n(&heap_gen, __ATOMIC_ACQUIRE);
+
+    if(tc.gen != gen)
+    {
+        if(tc.gen == 0)
+        {
+            pthread_setspecific(tc_key, &tc);
+        }
+        memset(tc.count, 0, sizeof(tc.count));
+        tc.gen = gen;
+    }
+}
+
+int mm_init(void)
+{
+    int ret, i;
+
+    pthread_once(&arena_once, arena_setup);
+    for(i = 0; i < NARENAS; i++)
+    {
+        pthread_mutex_lock(&arenas[i].lock);
+        arenas[i].remote = 0;
+    }
+    __atomic_add_fetch(&heap_gen, 1, __ATOMIC_RELEASE);
+    ret = heap_init();
+    for(i = NARENAS - 1; i >= 0; i--)
+    {
+        pthread_mutex_unlock(&arenas[i].lock);
+    }
+    return ret;
+}
+
+void *mm_malloc(size_t size)
+{
+    uint32_t c;
+    void *bp;
+
+    if(size == 0 || size > TC_MAX)
+    {
+        if(arena_lock() == NULL)
+            return NULL;
+        bp = heap_malloc(size);
+        pthread_mutex_unlock(&ar->lock);
+        return bp;
+    }
+
+    /* class c holds blocks with at least (c + 1) * DSIZE usable bytes */
+    c = (size - 1) / DSIZE;
+    tc_check();
+    if(tc.count[c] > 0)
+    {
+        return tc.blocks[c][--tc.count[c]];
+    }
+
+    if(arena_lock() == NULL)
+        return NULL;
+    bp = heap_malloc((c + 1) * DSIZE);
+    while(bp != NULL && tc.count[c] < TC_BATCH - 1)
+    {
+        void *extra = heap_malloc((c + 1) * DSIZE);
+        if(extra == NULL)
+        {
+            break;
+        }
+        tc.blocks[c][tc.count[c]++] = extra;
+    }
+    pthread_mutex_unlock(&ar->lock);
+    return bp;
+}
+
+void mm_free(void *bp)
+{
+    word_t usable;
+    uint32_t c;
+
+    if(bp == 0)
+        return;
+
+    if(IS_MAPPED(bp))
+    {
+        map_free(bp);
+        return;
+    }
+    usable = usable_size(bp);
+    if(usable > TC_MAX && ARENA_OF(bp) != home)
+    {
+        remote_free(ARENA_OF(bp), bp);
+        return;
+    }
+    if(usable > TC_MAX)
+    {
+        owner_lock(bp);
+        heap_free(bp);
+        pthread_mutex_unlock(&ar->lock);
+        return;
+    }
+
+    c = usable / DSIZE - 1;
+    tc_check();
+    if(tc.count[c] == TC_COUNT)
+    {
+        tc_flush(&tc, c, TC_COUNT - TC_BATCH);
+    }
+    tc.blocks[c][tc.count[c]++] = bp;
+}
+
+void *mm_realloc(void *ptr, size_t size)
+{
+    void *newp;
+
+    if(!IS_MAPPED(ptr))
+    {
+        owner_lock(ptr);
+    }
+    else if(arena_lock() == NULL)
+    {
+        return NULL;
+    }
+    newp = heap_realloc(ptr, size);
+    pthread_mutex_unlock(&ar->lock);
     return newp;
 }
 
+void *mm_memalign(size_t alignment, size_t size)
+{
+    void *bp;
+
+    if(arena_lock() == NULL)
+        return NULL;
+    bp = heap_memalign(alignment, size);
+    pthread_mutex_unlock(&ar->lock);
+    return bp;
+}
+
+/* cached blocks are never known to be zero, so those just get cleared */
+void *mm_calloc(size_t nmemb, size_t size)
+{
+    size_t bytes;
+    void *bp;
+
+    if(size != 0 && nmemb > MAX_REQUEST / size)
+    {
+        return NULL;
+    }
+    bytes = nmemb * size;
+    if(bytes != 0 && bytes <= TC_MAX)
+    {
+        if((bp = mm_malloc(bytes)) != NULL)
+        {
+            memset(bp, 0, bytes);
+        }
+        return bp;
+    }
+    if(arena_lock() == NULL)
+        return NULL;
+    bp = heap_calloc(bytes);
+    pthread_mutex_unlock(&ar->lock);
+    return bp;
+}
+
+/* the whole batch is one trip through the arena lock, past the cache */
+size_t mm_malloc_batch(size_t size, size_t n, void **out)
+{
+    size_t got;
+
+    if(n == 0 || arena_lock() == NULL)
+        return 0;
+    got = heap_malloc_batch(size, n, out);
+    pthread_mutex_unlock(&ar->lock);
+    return got;
+}
+
+/*
+ * Sorted, the blocks of one arena mostly sit together, and each such
+ * stretch is freed under one lock of its owner, past the cache.
+ */
+void mm_free_batch(void **ptrs, size_t n)
+{
+    size_t i, j, k, m, left;
+    void **p;
+    arena *a;
+
+    for(k = 0; k < n; k += m)
+    {
+        m = n - k < BATCH_SORT ? n - k : BATCH_SORT;
+        p = ptrs + k;
+        left = sort_blocks(p, m);
+        for(i = 0; i < left; i = j)
+        {
+            a = ARENA_OF(p[i]);
+            for(j = i + 1; j < left && ARENA_OF(p[j]) == a; j++)
+                ;
+            owner_lock(p[i]);
+            heap_free_sorted(p + i, j - i);
+            pthread_mutex_unlock(&ar->lock);
+        }
+    }
+}
+
+#else
+
+int mm_init(void)
+{
+    return heap_init();
+}
+
+void *mm_malloc(size_t size)
+{
+    return heap_malloc(size);
+}
+
+void mm_free(void *bp)
+{
+    heap_free(bp);
+}
+
+void *mm_realloc(void *ptr, size_t size)
+{
+    return heap_realloc(ptr, size);
+}
+
+void *mm_memalign(size_t alignment, size_t size)
+{
+    return heap_memalign(alignment, size);
+}
+
+void *mm_calloc(size_t nmemb, size_t size)
+{
+    if(size != 0 && nmemb > MAX_REQUEST / size)
+    {
+        return NULL;
+    }
+    return heap_calloc(nmemb * size);
+}
+
+size_t mm_malloc_batch(size_t size, size_t n, void **out)
+{
+    return heap_malloc_batch(size, n, out);
+}
+
+void mm_free_batch(void **ptrs, size_t n)
+{
+    size_t i, m;
+
+    for(i = 0; i < n; i += m)
+    {
+        m = n - i < BATCH_SORT ? n - i : BATCH_SORT;
+        heap_free_sorted(ptrs + i, sort_blocks(ptrs + i, m));
+    }
+}
+
+#endif
+
 static void ph(void)
 {
     printf("\n");
@@ -371,66 +2222,72 @@ static void ph(void)
     
     for(bp = start; GET_SIZE(HDRP(bp)) > 0; bp = NEXT_BLKP(bp))
     {
-        uint32_t hsize, halloc, fsize, falloc;
+        word_t hsize, halloc, fsize, falloc;
 
         hsize = GET_SIZE(HDRP(bp));
         halloc = GET_ALLOC(HDRP(bp));  
-        fsize = GET_SIZE(FTRP(bp));
-        falloc = GET_ALLOC(FTRP(bp)); 
+        fsize = halloc ? 0 : GET_SIZE(FTRP(bp));
+        falloc = halloc ? 1 : GET_ALLOC(FTRP(bp)); 
 
         if(hsize == 0)
         {
             printf("%p: EOL\n", bp);
         }
 
-        printf("%p: header: [%d:%c] (next [%p] prev [%p]) footer: [%d:%c]\n", bp, (int) hsize, (halloc ? 'a' : 'f'), ((freelist*)bp)->next, ((freelist*)bp)->prev,(int) fsize, (falloc ? 'a' : 'f')); 
+        printf("%p: header: [%d:%c] (next [%p] prev [%p]) footer: [%d:%c]\n", bp, (int) hsize, (halloc ? 'a' : 'f'), NEXT_FREE((freelist*)bp), PREV_FREE((freelist*)bp),(int) fsize, (falloc ? 'a' : 'f')); 
     }
     if(GET_SIZE(HDRP(bp)) == 0)
     {
-        uint32_t hsize, halloc, fsize, falloc;
+        word_t hsize, halloc, fsize, falloc;
 
         hsize = GET_SIZE(HDRP(bp));
         halloc = GET_ALLOC(HDRP(bp));
         fsize = GET_SIZE(FTRP(bp));
         falloc = GET_ALLOC(FTRP(bp));
         
-        printf("last block %p: header: [%d:%c] (next [%p] prev [%p]) footer: [%d:%c]\n", bp, (int) hsize, (halloc ? 'a' : 'f'), ((freelist*)bp)->next, ((freelist*)bp)->prev,(int) fsize, (falloc ? 'a' : 'f'));
+        printf("last block %p: header: [%d:%c] (next [%p] prev [%p]) footer: [%d:%c]\n", bp, (int) hsize, (halloc ? 'a' : 'f'), NEXT_FREE((freelist*)bp), PREV_FREE((freelist*)bp),(int) fsize, (falloc ? 'a' : 'f'));
     }
 }
 
 static void pf(void)
 {
-    freelist* bp = firstfree;
-    do
+    int bin;
+    freelist* bp;
+    for(bin = 0; bin < NBINS; bin++)
     {
-        uint32_t hsize, halloc, fsize, falloc;
+        if(ar->bins[bin] != NULL)
+        {
+            printf("bin %d:\n", bin);
+        }
+        for(bp = ar->bins[bin]; bp != NULL; bp = NEXT_FREE(bp))
+        {
+            word_t hsize, halloc, fsize, falloc;
 
-        hsize = GET_SIZE(HDRP(bp));
-        halloc = GET_ALLOC(HDRP(bp));  
-        fsize = GET_SIZE(FTRP(bp));
-        falloc = GET_ALLOC(FTRP(bp));
-        printf("%p: header: [%d:%c] (next [%p] prev [%p]) footer: [%d:%c]\n", bp, (int) hsize, (halloc ? 'a' : 'f'), ((freelist*)bp)->next, ((freelist*)bp)->prev,(int) fsize, (falloc ? 'a' : 'f'));
-        bp = bp->next;
+            hsize = GET_SIZE(HDRP(bp));
+            halloc = GET_ALLOC(HDRP(bp));  
+            fsize = GET_SIZE(FTRP(bp));
+            falloc = GET_ALLOC(FTRP(bp));
+            printf("%p: header: [%d:%c] (next [%p] prev [%p]) footer: [%d:%c]\n", bp, (int) hsize, (halloc ? 'a' : 'f'), NEXT_FREE((freelist*)bp), PREV_FREE((freelist*)bp),(int) fsize, (falloc ? 'a' : 'f'));
+        }
     }
-    while(bp != NULL);
 }
 
 static void pb(void *bp) 
 {
-    uint32_t hsize, halloc, fsize, falloc;
+    word_t hsize, halloc, fsize, falloc;
 
     hsize = GET_SIZE(HDRP(bp));
     halloc = GET_ALLOC(HDRP(bp));  
-    fsize = GET_SIZE(FTRP(bp));
-    falloc = GET_ALLOC(FTRP(bp));  
+    fsize = halloc ? 0 : GET_SIZE(FTRP(bp));
+    falloc = halloc ? 1 : GET_ALLOC(FTRP(bp));  
     printf("\n");
     if(hsize == 0)
     {
         printf("%p: EOL\n", bp);
-        printf("%p: header: [%d:%c] (next [%p] prev [%p]) footer: [%d:%c]\n", bp, (int) hsize, (halloc ? 'a' : 'f'), ((freelist*)bp)->next, ((freelist*)bp)->prev,(int) fsize, (falloc ? 'a' : 'f'));
+        printf("%p: header: [%d:%c] (next [%p] prev [%p]) footer: [%d:%c]\n", bp, (int) hsize, (halloc ? 'a' : 'f'), NEXT_FREE((freelist*)bp), PREV_FREE((freelist*)bp),(int) fsize, (falloc ? 'a' : 'f'));
         return;
     }
 
-    printf("%p: header: [%d:%c] (next [%p] prev [%p]) footer: [%d:%c]\n", bp, (int) hsize, (halloc ? 'a' : 'f'), ((freelist*)bp)->next, ((freelist*)bp)->prev,(int) fsize, (falloc ? 'a' : 'f')); 
+    printf("%p: header: [%d:%c] (next [%p] prev [%p]) footer: [%d:%c]\n", bp, (int) hsize, (halloc ? 'a' : 'f'), NEXT_FREE((freelist*)bp), PREV_FREE((freelist*)bp),(int) fsize, (falloc ? 'a' : 'f')); 
 }
 
@@ -123,13 +123,13 @@ static void *extend_heap(uint32_t words)
   return coalesce(bp);
 }
 
-void *mm_malloc(uint32_t size)
+void *mm_malloc(size_t size)
 {
   uint32_t asize;
   uint32_t extendsize;
   void *bp;
 
-  if(size == 0)
+  if(size == 0 || size > UINT32_MAX / 2)
   {
     return NULL;
   }
@@ -307,10 +307,14 @@ static void *coalesce(void *bp)
   return bp;
 }
 
-void *mm_realloc(void *ptr, uint32_t size)
+void *mm_realloc(void *ptr, size_t size)
 {
    size_t oldsize, asize;
    void* newptr;
+   if(size > UINT32_MAX / 2)
+   {
+       return NULL;
+   }
    if(size==0)
    {
        return 0;
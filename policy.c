@@ -0,0 +1,521 @@
+/*
+ * policy.c - Explicit free list allocator specialised at compile time.
+ *
+ * mm2.c, explicit.c and explicit_cir.c are the same boundary tag
+ * allocator (4 byte header and footer holding size | alloc) with a
+ * different fit rule or chunk size each, and implict.c is its
+ * implicit-list first fit ancestor. This file is that allocator once,
+ * with the rules picked by the preprocessor so every combination
+ * compiles to its own engine with no run-time dispatch (README says
+ * which one each older file is closest to):
+ *
+ *   FIT       FIT_FIRST  first block that fits
+ *             FIT_NEXT   first fit, resuming where the last search ended
+ *             FIT_BEST   smallest block that fits
+ *             FIT_GOOD   best of the first GOOD_PROBES blocks that fit
+ *   ORDER     ORDER_LIFO freed blocks go to the front of the list
+ *             ORDER_FIFO freed blocks go to the back
+ *             ORDER_ADDR the list is kept in address order
+ *   COALESCE  COALESCE_IMMEDIATE  merge with free neighbours on free
+ *             COALESCE_DEFERRED   free without merging; merge the
+ *                                 whole heap when a fit fails
+ *
+ * "make mdriver-policy FIT=NEXT ORDER=ADDR COALESCE=DEFERRED" builds
+ * one, "make policies" runs the driver over all of them.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <memory.h>
+#include "mm.h"
+#include "memlib.h"
+
+team_t team = {
+    "The BOI",
+    "Vincent Liu",
+    "vili1624@colorado.edu",
+    "Christian Sousa",
+    "chso8299@colorado.edu"
+};
+
+#define WSIZE       4
+#define DSIZE       8
+#define CHUNKSIZE  (1<<8)
+#define OVERHEAD    8
+#define MINIMUM     24
+
+#define FIT_FIRST   0
+#define FIT_NEXT    1
+#define FIT_BEST    2
+#define FIT_GOOD    3
+
+#define ORDER_LIFO  0
+#define ORDER_FIFO  1
+#define ORDER_ADDR  2
+
+#define COALESCE_IMMEDIATE  0
+#define COALESCE_DEFERRED   1
+
+#ifndef FIT
+#define FIT         FIT_BEST
+#endif
+#ifndef ORDER
+#define ORDER       ORDER_LIFO
+#endif
+#ifndef COALESCE
+#define COALESCE    COALESCE_IMMEDIATE
+#endif
+#ifndef GOOD_PROBES
+#define GOOD_PROBES 8
+#endif
+
+static inline int MAX(int x, int y)
+{
+    return x > y ? x : y;
+}
+
+static inline uint32_t PACK(uint32_t size, int alloc)
+{
+    return ((size) | (alloc & 0x1));
+}
+
+static inline uint32_t GET(void *p)
+{
+    return  *(uint32_t *)p;
+}
+
+static inline void PUT( void *p, uint32_t val)
+{
+    *((uint32_t *)p) = val;
+}
+
+static inline uint32_t GET_SIZE(void *p)
+{
+    return GET(p) & ~0x7;
+}
+
+static inline int GET_ALLOC(void *p)
+{
+    return GET(p) & 0x1;
+}
+
+static inline void *HDRP(void *bp)
+{
+    return ( (char *)bp) - WSIZE;
+}
+
+static inline void *FTRP(void *bp)
+{
+    return ((char *)(bp) + GET_SIZE(HDRP(bp)) - DSIZE);
+}
+
+static inline void *NEXT_BLKP(void *bp)
+{
+    return  ((char *)(bp) + GET_SIZE(((char *)(bp) - WSIZE)));
+}
+
+static inline void* PREV_BLKP(void *bp)
+{
+    return  ((char *)(bp) - GET_SIZE(((char *)(bp) - DSIZE)));
+}
+
+typedef struct freelist
+{
+    struct freelist *prev;
+    struct freelist *next;
+}freelist;
+
+static void *start;
+static freelist *head;
+#if ORDER == ORDER_FIFO
+static freelist *tail;
+#endif
+#if FIT == FIT_NEXT
+static freelist *rover;
+#endif
+#if COALESCE == COALESCE_DEFERRED
+static int pending;
+#endif
+
+static void *extend_heap(uint32_t words);
+static void insert_to_free(freelist *bp);
+static void remove_from_free(freelist* bp);
+static void *find_fit(uint32_t asize);
+static void place(void *bp, uint32_t asize);
+static void *coalesce(void *bp);
+#if COALESCE == COALESCE_DEFERRED
+static int coalesce_all(void);
+#endif
+
+int mm_init(void)
+{
+    head = NULL;
+#if ORDER == ORDER_FIFO
+    tail = NULL;
+#endif
+#if FIT == FIT_NEXT
+    rover = NULL;
+#endif
+#if COALESCE == COALESCE_DEFERRED
+    pending = 0;
+#endif
+
+    if((start = mem_sbrk(4*WSIZE)) == (void*) -1)
+        return -1;
+
+    PUT(start, 0);
+    PUT(start + (WSIZE), PACK(DSIZE, 1));
+    PUT(start + (2*WSIZE), PACK(DSIZE, 1));
+    PUT(start + (3*WSIZE), PACK(0,1));
+    start += (2*WSIZE);
+
+    if(extend_heap(CHUNKSIZE/WSIZE) == NULL)
+        return -1;
+
+    return 0;
+}
+
+static void *extend_heap(uint32_t words)
+{
+    void *bp;
+    uint32_t size;
+    size = (words%2) ? (words+1) * WSIZE : words * WSIZE;
+    if((bp = mem_sbrk(size)) == (void*) -1)
+        return NULL;
+
+    PUT(HDRP(bp), PACK(size, 0));
+    PUT(FTRP(bp), PACK(size, 0));
+    PUT(HDRP(NEXT_BLKP(bp)), PACK(0,1));
+
+    return coalesce(bp);
+}
+
+void *mm_malloc(size_t size)
+{
+    uint32_t asize;
+    uint32_t extendsize;
+    void *bp;
+
+    if(size == 0 || size > UINT32_MAX / 2)
+    {
+        return NULL;
+    }
+    else if(size <= DSIZE)
+    {
+        size = 2*DSIZE;
+    }
+    else if((size%DSIZE) != 0)
+    {
+        uint32_t times = size/DSIZE;
+        size = (times+1)* DSIZE;
+    }
+    asize = size + DSIZE;
+    bp = find_fit(asize);
+#if COALESCE == COALESCE_DEFERRED
+    if(bp == NULL && coalesce_all())
+    {
+        bp = find_fit(asize);
+    }
+#endif
+    if(bp != NULL)
+    {
+        place(bp, asize);
+        return bp;
+    }
+
+    extendsize = MAX(asize, CHUNKSIZE);
+    if((bp = extend_heap(extendsize/WSIZE)) == NULL)
+        return NULL;
+
+    place(bp, asize);
+    return bp;
+}
+
+static void *find_fit(uint32_t asize)
+{
+    freelist *bp;
+#if FIT == FIT_FIRST
+    for(bp = head; bp != NULL; bp = bp->next)
+    {
+        if(GET_SIZE(HDRP(bp)) >= asize)
+        {
+            return bp;
+        }
+    }
+    return NULL;
+#elif FIT == FIT_NEXT
+    freelist *from = rover != NULL ? rover : head;
+
+    for(bp = from; bp != NULL; bp = bp->next)
+    {
+        if(GET_SIZE(HDRP(bp)) >= asize)
+        {
+            return rover = bp;
+        }
+    }
+    for(bp = head; bp != from; bp = bp->next)
+    {
+        if(GET_SIZE(HDRP(bp)) >= asize)
+        {
+            return rover = bp;
+        }
+    }
+    return NULL;
+#else
+    freelist *best = NULL;
+    uint32_t size, best_size = 0;
+#if FIT == FIT_GOOD
+    int probes = 0;
+#endif
+
+    for(bp = head; bp != NULL; bp = bp->next)
+    {
+        size = GET_SIZE(HDRP(bp));
+        if(size < asize)
+        {
+            continue;
+        }
+        if(size == asize)
+        {
+            return bp;
+        }
+        if(best == NULL || size < best_size)
+        {
+            best = bp;
+            best_size = size;
+        }
+#if FIT == FIT_GOOD
+        if(++probes == GOOD_PROBES)
+        {
+            break;
+        }
+#endif
+    }
+    return best;
+#endif
+}
+
+static void place(void *bp, uint32_t asize)
+{
+    uint32_t csize = GET_SIZE(HDRP(bp));
+
+    remove_from_free((freelist*)bp);
+    if((csize - asize) >= MINIMUM)
+    {
+        PUT(HDRP(bp), PACK(asize, 1));
+        PUT(FTRP(bp), PACK(asize, 1));
+
+        bp = NEXT_BLKP(bp);
+        PUT(HDRP(bp), PACK(csize - asize, 0));
+        PUT(FTRP(bp), PACK(csize - asize, 0));
+        insert_to_free((freelist*)bp);
+    }
+    else
+    {
+        PUT(HDRP(bp), PACK(csize, 1));
+        PUT(FTRP(bp), PACK(csize, 1));
+    }
+}
+
+static void remove_from_free(freelist* bp)
+{
+#if FIT == FIT_NEXT
+    if(rover == bp)
+    {
+        rover = bp->next;
+    }
+#endif
+    if(bp->prev == NULL)
+    {
+        head = bp->next;
+    }
+    else
+    {
+        bp->prev->next = bp->next;
+    }
+    if(bp->next != NULL)
+    {
+        bp->next->prev = bp->prev;
+    }
+#if ORDER == ORDER_FIFO
+    else
+    {
+        tail = bp->prev;
+    }
+#endif
+}
+
+static void insert_to_free(freelist *bp)
+{
+#if ORDER == ORDER_LIFO
+    bp->prev = NULL;
+    bp->next = head;
+    if(head != NULL)
+    {
+        head->prev = bp;
+    }
+    head = bp;
+#elif ORDER == ORDER_FIFO
+    bp->prev = tail;
+    bp->next = NULL;
+    if(tail != NULL)
+    {
+        tail->next = bp;
+    }
+    else
+    {
+        head = bp;
+    }
+    tail = bp;
+#else
+    freelist *prev = NULL, *next = head;
+
+    while(next != NULL && next < bp)
+    {
+        prev = next;
+        next = next->next;
+    }
+    bp->prev = prev;
+    bp->next = next;
+    if(prev != NULL)
+    {
+        prev->next = bp;
+    }
+    else
+    {
+        head = bp;
+    }
+    if(next != NULL)
+    {
+        next->prev = bp;
+    }
+#endif
+}
+
+void mm_free(void *bp)
+{
+    if(bp == 0)
+        return;
+
+    uint32_t size = GET_SIZE(HDRP(bp));
+
+    PUT(HDRP(bp), PACK(size, 0));
+    PUT(FTRP(bp), PACK(size, 0));
+
+#if COALESCE == COALESCE_DEFERRED
+    insert_to_free((freelist*)bp);
+    pending = 1;
+#else
+    coalesce(bp);
+#endif
+}
+
+static void *coalesce(void *bp)
+{
+    size_t prev_alloc = GET_ALLOC(FTRP(PREV_BLKP(bp)));
+    size_t next_alloc = GET_ALLOC(HDRP(NEXT_BLKP(bp)));
+    size_t size = GET_SIZE(HDRP(bp));
+
+    if(!next_alloc)
+    {
+        size = size + GET_SIZE(HDRP(NEXT_BLKP(bp)));
+        remove_from_free((freelist*)NEXT_BLKP(bp));
+    }
+    if(!prev_alloc)
+    {
+        size = size + GET_SIZE(HDRP(PREV_BLKP(bp)));
+        remove_from_free((freelist*)PREV_BLKP(bp));
+        bp = PREV_BLKP(bp);
+    }
+    PUT(HDRP(bp), PACK(size, 0));
+    PUT(FTRP(bp), PACK(size, 0));
+    insert_to_free((freelist*)bp);
+    return bp;
+}
+
+#if COALESCE == COALESCE_DEFERRED
+/*
+ * coalesce_all - merge every run of adjacent free blocks in the heap,
+ *     returning whether any merged. The first block of a run keeps
+ *     its place in the list and just grows. Nothing can merge unless
+ *     something was freed since the last pass.
+ */
+static int coalesce_all(void)
+{
+    void *bp, *next;
+    uint32_t size;
+    int merged = 0;
+
+    if(!pending)
+    {
+        return 0;
+    }
+    pending = 0;
+
+    for(bp = start; GET_SIZE(HDRP(bp)) > 0; bp = NEXT_BLKP(bp))
+    {
+        if(GET_ALLOC(HDRP(bp)))
+        {
+            continue;
+        }
+        size = GET_SIZE(HDRP(bp));
+        while(!GET_ALLOC(HDRP(next = (char *)bp + size)))
+        {
+            remove_from_free((freelist*)next);
+            size += GET_SIZE(HDRP(next));
+            merged = 1;
+        }
+        PUT(HDRP(bp), PACK(size, 0));
+        PUT(FTRP(bp), PACK(size, 0));
+    }
+    return merged;
+}
+#endif
+
+void *mm_realloc(void *ptr, size_t size)
+{
+    void *newp;
+    uint32_t copySize;
+
+    if(size > UINT32_MAX / 2)
+    {
+        return NULL;
+    }
+
+    uint32_t next_alloc = GET_ALLOC(HDRP(NEXT_BLKP(ptr)));
+
+    uint32_t next_size = GET_SIZE(HDRP(NEXT_BLKP(ptr)));
+
+    uint32_t curr_size = GET_SIZE(HDRP(ptr));
+    uint32_t combine_size = curr_size + next_size;
+    uint32_t asize = size + DSIZE;
+
+    if(curr_size > asize)
+    {
+        return ptr;
+    }
+
+    if(!next_alloc && combine_size >= asize)
+    {
+        remove_from_free((freelist*)NEXT_BLKP(ptr));
+        PUT(HDRP(ptr), PACK(combine_size, 1));
+        PUT(FTRP(ptr), PACK(combine_size, 1));
+
+        return ptr;
+    }
+
+    newp = mm_malloc(size);
+    if (newp == NULL)
+    {
+        printf("ERROR: mm_malloc failed in mm_realloc\n");
+        exit(1);
+    }
+    copySize = GET_SIZE(HDRP(ptr)) - DSIZE;
+    if(size < copySize)
+    {
+        copySize = size;
+    }
+    memcpy(newp, ptr, copySize);
+    mm_free(ptr);
+    return newp;
+}
@@ -0,0 +1,680 @@
+/*
+ * rbfit.c - Best fit allocator over a size-keyed red-black tree.
+ *
+ * Uses the same boundary tag block format as mm.c (4 byte header
+ * and footer holding size | alloc). Free blocks of TREE_MIN bytes
+ * or more are indexed by a red-black tree keyed by block size. The
+ * tree node lives in the free block's payload, and bit 1 of the
+ * header holds its colour. Only one block of each size sits in the
+ * tree; further blocks of the same size are chained off it through
+ * next/prev, so a tree node is recognised by prev == NULL.
+ *
+ * Free blocks too small to hold a node (MINIMUM up to TREE_MIN) go
+ * in one exact-size side list each.
+ *
+ * find_fit is a lower-bound query on the tree, so best fit costs
+ * O(log n) instead of a walk over every free block.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <memory.h>
+#include "mm.h"
+#include "memlib.h"
+
+team_t team = {
+    "The BOI",
+    "Vincent Liu",
+    "vili1624@colorado.edu",
+    "Christian Sousa",
+    "chso8299@colorado.edu"
+};
+
+#define WSIZE       4
+#define DSIZE       8
+#define CHUNKSIZE  (1<<8)
+#define OVERHEAD    8
+#define MINIMUM     24
+#define TREE_MIN    (OVERHEAD + sizeof(tnode))
+#define NSMALL      ((TREE_MIN - MINIMUM) / DSIZE)
+
+static inline int MAX(int x, int y)
+{
+    return x > y ? x : y;
+}
+
+static inline uint32_t PACK(uint32_t size, int alloc)
+{
+    return ((size) | (alloc & 0x1));
+}
+
+static inline uint32_t GET(void *p)
+{
+    return  *(uint32_t *)p;
+}
+
+static inline void PUT( void *p, uint32_t val)
+{
+    *((uint32_t *)p) = val;
+}
+
+static inline uint32_t GET_SIZE(void *p)
+{
+    return GET(p) & ~0x7;
+}
+
+static inline int GET_ALLOC(void *p)
+{
+    return GET(p) & 0x1;
+}
+
+static inline void *HDRP(void *bp)
+{
+    return ( (char *)bp) - WSIZE;
+}
+
+static inline void *FTRP(void *bp)
+{
+    return ((char *)(bp) + GET_SIZE(HDRP(bp)) - DSIZE);
+}
+
+static inline void *NEXT_BLKP(void *bp)
+{
+    return  ((char *)(bp) + GET_SIZE(((char *)(bp) - WSIZE)));
+}
+
+static inline void* PREV_BLKP(void *bp)
+{
+    return  ((char *)(bp) - GET_SIZE(((char *)(bp) - DSIZE)));
+}
+
+typedef struct freelist
+{
+    struct freelist *prev;
+    struct freelist *next;
+}freelist;
+
+typedef struct tnode
+{
+    struct tnode *prev;
+    struct tnode *next;
+    struct tnode *left;
+    struct tnode *right;
+    struct tnode *parent;
+}tnode;
+
+static tnode *root;
+static freelist *small[NSMALL];
+
+static void *extend_heap(uint32_t words);
+static void insert_to_free(freelist *bp);
+static void remove_from_free(freelist* bp);
+static void *find_fit(uint32_t asize);
+static void place(void *bp, uint32_t asize);
+static void *coalesce(void *bp);
+
+/*
+ * Colour lives in bit 1 of the header; NULL leaves are black.
+ */
+static inline int IS_RED(tnode *n)
+{
+    return n != NULL && (GET(HDRP(n)) & 0x2);
+}
+
+static inline void SET_RED(tnode *n)
+{
+    PUT(HDRP(n), GET(HDRP(n)) | 0x2);
+}
+
+static inline void SET_BLACK(tnode *n)
+{
+    if(n != NULL)
+    {
+        PUT(HDRP(n), GET(HDRP(n)) & ~0x2);
+    }
+}
+
+static inline void SET_COLOR(tnode *n, tnode *from)
+{
+    if(IS_RED(from))
+        SET_RED(n);
+    else
+        SET_BLACK(n);
+}
+
+static void rotate_left(tnode *x)
+{
+    tnode *y = x->right;
+
+    x->right = y->left;
+    if(y->left != NULL)
+        y->left->parent = x;
+    y->parent = x->parent;
+    if(x->parent == NULL)
+        root = y;
+    else if(x == x->parent->left)
+        x->parent->left = y;
+    else
+        x->parent->right = y;
+    y->left = x;
+    x->parent = y;
+}
+
+static void rotate_right(tnode *x)
+{
+    tnode *y = x->left;
+
+    x->left = y->right;
+    if(y->right != NULL)
+        y->right->parent = x;
+    y->parent = x->parent;
+    if(x->parent == NULL)
+        root = y;
+    else if(x == x->parent->right)
+        x->parent->right = y;
+    else
+        x->parent->left = y;
+    y->right = x;
+    x->parent = y;
+}
+
+/*
+ * transplant - hang v where u was hanging
+ */
+static void transplant(tnode *u, tnode *v)
+{
+    if(u->parent == NULL)
+        root = v;
+    else if(u == u->parent->left)
+        u->parent->left = v;
+    else
+        u->parent->right = v;
+    if(v != NULL)
+        v->parent = u->parent;
+}
+
+static void tree_insert(tnode *z)
+{
+    uint32_t size = GET_SIZE(HDRP(z));
+    tnode *p = NULL;
+    tnode *x = root;
+
+    z->prev = NULL;
+    while(x != NULL)
+    {
+        uint32_t xsize = GET_SIZE(HDRP(x));
+        if(size == xsize)
+        {
+            /* same size already in the tree, just chain behind it */
+            z->prev = x;
+            z->next = x->next;
+            if(x->next != NULL)
+                x->next->prev = z;
+            x->next = z;
+            return;
+        }
+        p = x;
+        x = (size < xsize) ? x->left : x->right;
+    }
+
+    z->next = NULL;
+    z->left = NULL;
+    z->right = NULL;
+    z->parent = p;
+    if(p == NULL)
+        root = z;
+    else if(size < GET_SIZE(HDRP(p)))
+        p->left = z;
+    else
+        p->right = z;
+    SET_RED(z);
+
+    while(IS_RED(z->parent))
+    {
+        tnode *g = z->parent->parent;
+        if(z->parent == g->left)
+        {
+            tnode *u = g->right;
+            if(IS_RED(u))
+            {
+                SET_BLACK(z->parent);
+                SET_BLACK(u);
+                SET_RED(g);
+                z = g;
+            }
+            else
+            {
+                if(z == z->parent->right)
+                {
+                    z = z->parent;
+                    rotate_left(z);
+                }
+                SET_BLACK(z->parent);
+                SET_RED(g);
+                rotate_right(g);
+            }
+        }
+        else
+        {
+            tnode *u = g->left;
+            if(IS_RED(u))
+            {
+                SET_BLACK(z->parent);
+                SET_BLACK(u);
+                SET_RED(g);
+                z = g;
+            }
+            else
+            {
+                if(z == z->parent->left)
+                {
+                    z = z->parent;
+                    rotate_right(z);
+                }
+                SET_BLACK(z->parent);
+                SET_RED(g);
+                rotate_left(g);
+            }
+        }
+    }
+    SET_BLACK(root);
+}
+
+static void delete_fixup(tnode *x, tnode *xp)
+{
+    tnode *w;
+
+    while(x != root && !IS_RED(x))
+    {
+        if(x == xp->left)
+        {
+            w = xp->right;
+            if(IS_RED(w))
+            {
+                SET_BLACK(w);
+                SET_RED(xp);
+                rotate_left(xp);
+                w = xp->right;
+            }
+            if(!IS_RED(w->left) && !IS_RED(w->right))
+            {
+                SET_RED(w);
+                x = xp;
+                xp = x->parent;
+            }
+            else
+            {
+                if(!IS_RED(w->right))
+                {
+                    SET_BLACK(w->left);
+                    SET_RED(w);
+                    rotate_right(w);
+                    w = xp->right;
+                }
+                SET_COLOR(w, xp);
+                SET_BLACK(xp);
+                SET_BLACK(w->right);
+                rotate_left(xp);
+                x = root;
+            }
+        }
+        else
+        {
+            w = xp->left;
+            if(IS_RED(w))
+            {
+                SET_BLACK(w);
+                SET_RED(xp);
+                rotate_right(xp);
+                w = xp->left;
+            }
+            if(!IS_RED(w->right) && !IS_RED(w->left))
+            {
+                SET_RED(w);
+                x = xp;
+                xp = x->parent;
+            }
+            else
+            {
+                if(!IS_RED(w->left))
+                {
+                    SET_BLACK(w->right);
+                    SET_RED(w);
+                    rotate_left(w);
+                    w = xp->left;
+                }
+                SET_COLOR(w, xp);
+                SET_BLACK(xp);
+                SET_BLACK(w->left);
+                rotate_right(xp);
+                x = root;
+            }
+        }
+    }
+    SET_BLACK(x);
+}
+
+static void tree_remove(tnode *z)
+{
+    tnode *x, *xp, *y;
+    int y_red;
+
+    if(z->prev != NULL)
+    {
+        /* chained duplicate, the tree itself does not change */
+        z->prev->next = z->next;
+        if(z->next != NULL)
+            z->next->prev = z->prev;
+        return;
+    }
+
+    if(z->next != NULL)
+    {
+        /* promote the next block of the same size into z's place */
+        y = z->next;
+        y->prev = NULL;
+        y->left = z->left;
+        y->right = z->right;
+        y->parent = z->parent;
+        SET_COLOR(y, z);
+        if(y->left != NULL)
+            y->left->parent = y;
+        if(y->right != NULL)
+            y->right->parent = y;
+        transplant(z, y);
+        return;
+    }
+
+    y = z;
+    y_red = IS_RED(y);
+    if(z->left == NULL)
+    {
+        x = z->right;
+        xp = z->parent;
+        transplant(z, z->right);
+    }
+    else if(z->right == NULL)
+    {
+        x = z->left;
+        xp = z->parent;
+        transplant(z, z->left);
+    }
+    else
+    {
+        for(y = z->right; y->left != NULL; y = y->left)
+            ;
+        y_red = IS_RED(y);
+        x = y->right;
+        if(y->parent == z)
+        {
+            xp = y;
+        }
+        else
+        {
+            xp = y->parent;
+            transplant(y, y->right);
+            y->right = z->right;
+            y->right->parent = y;
+        }
+        transplant(z, y);
+        y->left = z->left;
+        y->left->parent = y;
+        SET_COLOR(y, z);
+    }
+    if(!y_red)
+        delete_fixup(x, xp);
+}
+
+int mm_init(void)
+{
+    void *start;
+
+    root = NULL;
+    memset(small, 0, sizeof(small));
+
+    if((start = mem_sbrk(4*WSIZE)) == (void*) -1)
+        return -1;
+
+    PUT(start, 0);
+    PUT(start + (WSIZE), PACK(DSIZE, 1));
+    PUT(start + (2*WSIZE), PACK(DSIZE, 1));
+    PUT(start + (3*WSIZE), PACK(0,1));
+
+    if(extend_heap(CHUNKSIZE/WSIZE) == NULL)
+        return -1;
+
+    return 0;
+}
+
+static void *extend_heap(uint32_t words)
+{
+    void *bp;
+    uint32_t size;
+    size = (words%2) ? (words+1) * WSIZE : words * WSIZE;
+    if((bp = mem_sbrk(size)) == (void*) -1)
+        return NULL;
+
+    PUT(HDRP(bp), PACK(size, 0));
+    PUT(FTRP(bp), PACK(size, 0));
+    PUT(HDRP(NEXT_BLKP(bp)), PACK(0,1));
+
+    return coalesce(bp);
+}
+
+void *mm_malloc(size_t size)
+{
+    uint32_t asize;
+    uint32_t extendsize;
+    void *bp;
+
+    if(size == 0 || size > UINT32_MAX / 2)
+    {
+        return NULL;
+    }
+    else if(size <= DSIZE)
+    {
+        size = 2*DSIZE;
+    }
+    else if((size%DSIZE) != 0)
+    {
+        uint32_t times = size/DSIZE;
+        size = (times+1)* DSIZE;
+    }
+    asize = size + DSIZE;
+    if((bp = find_fit(asize)) != NULL)
+    {
+        place(bp, asize);
+        return bp;
+    }
+
+    extendsize = MAX(asize, CHUNKSIZE);
+    if((bp = extend_heap(extendsize/WSIZE)) == NULL)
+        return NULL;
+
+    place(bp, asize);
+    return bp;
+}
+
+static void *find_fit(uint32_t asize)
+{
+    tnode *x;
+    tnode *best = NULL;
+    uint32_t i;
+
+    for(i = (asize - MINIMUM) / DSIZE; i < NSMALL; i++)
+    {
+        if(small[i] != NULL)
+        {
+            return small[i];
+        }
+    }
+
+    for(x = root; x != NULL; )
+    {
+        uint32_t xsize = GET_SIZE(HDRP(x));
+        if(xsize == asize)
+        {
+            best = x;
+            break;
+        }
+        if(xsize > asize)
+        {
+            best = x;
+            x = x->left;
+        }
+        else
+        {
+            x = x->right;
+        }
+    }
+
+    /* hand out a chained duplicate if there is one, the tree stays put */
+    if(best != NULL && best->next != NULL)
+    {
+        return best->next;
+    }
+    return best;
+}
+
+static void place(void *bp, uint32_t asize)
+{
+    uint32_t csize = GET_SIZE(HDRP(bp));
+
+    remove_from_free((freelist*)bp);
+    if((csize - asize) >= MINIMUM)
+    {
+        PUT(HDRP(bp), PACK(asize, 1));
+        PUT(FTRP(bp), PACK(asize, 1));
+
+        bp = NEXT_BLKP(bp);
+        PUT(HDRP(bp), PACK(csize - asize, 0));
+        PUT(FTRP(bp), PACK(csize - asize, 0));
+        insert_to_free((freelist*)bp);
+    }
+    else
+    {
+        PUT(HDRP(bp), PACK(csize, 1));
+        PUT(FTRP(bp), PACK(csize, 1));
+    }
+}
+
+static void remove_from_free(freelist* bp)
+{
+    uint32_t size = GET_SIZE(HDRP(bp));
+
+    if(size >= TREE_MIN)
+    {
+        tree_remove((tnode*)bp);
+        return;
+    }
+
+    if(bp->prev == NULL)
+        small[(size - MINIMUM) / DSIZE] = bp->next;
+    else
+        bp->prev->next = bp->next;
+    if(bp->next != NULL)
+        bp->next->prev = bp->prev;
+}
+
+static void insert_to_free(freelist *bp)
+{
+    uint32_t size = GET_SIZE(HDRP(bp));
+    freelist **head;
+
+    if(size >= TREE_MIN)
+    {
+        tree_insert((tnode*)bp);
+        return;
+    }
+
+    head = &small[(size - MINIMUM) / DSIZE];
+    bp->prev = NULL;
+    bp->next = *head;
+    if(*head != NULL)
+        (*head)->prev = bp;
+    *head = bp;
+}
+
+void mm_free(void *bp)
+{
+    if(bp == 0)
+        return;
+
+    uint32_t size = GET_SIZE(HDRP(bp));
+
+    PUT(HDRP(bp), PACK(size, 0));
+    PUT(FTRP(bp), PACK(size, 0));
+
+    coalesce(bp);
+}
+
+static void *coalesce(void *bp)
+{
+    size_t prev_alloc = GET_ALLOC(FTRP(PREV_BLKP(bp)));
+    size_t next_alloc = GET_ALLOC(HDRP(NEXT_BLKP(bp)));
+    size_t size = GET_SIZE(HDRP(bp));
+
+    if(!next_alloc)
+    {
+        size = size + GET_SIZE(HDRP(NEXT_BLKP(bp)));
+        remove_from_free((freelist*)NEXT_BLKP(bp));
+    }
+    if(!prev_alloc)
+    {
+        size = size + GET_SIZE(HDRP(PREV_BLKP(bp)));
+        remove_from_free((freelist*)PREV_BLKP(bp));
+        bp = PREV_BLKP(bp);
+    }
+    PUT(HDRP(bp), PACK(size, 0));
+    PUT(FTRP(bp), PACK(size, 0));
+    insert_to_free((freelist*)bp);
+    return bp;
+}
+
+void *mm_realloc(void *ptr, size_t size)
+{
+    void *newp;
+    uint32_t copySize;
+
+    if(size > UINT32_MAX / 2)
+    {
+        return NULL;
+    }
+
+    uint32_t next_alloc = GET_ALLOC(HDRP(NEXT_BLKP(ptr)));
+
+    uint32_t next_size = GET_SIZE(HDRP(NEXT_BLKP(ptr)));
+
+    uint32_t curr_size = GET_SIZE(HDRP(ptr));
+    uint32_t combine_size = curr_size + next_size;
+    uint32_t asize = size + DSIZE;
+
+    if(curr_size > asize)
+    {
+        return ptr;
+    }
+
+    if(!next_alloc && combine_size >= asize)
+    {
+        remove_from_free((freelist*)NEXT_BLKP(ptr));
+        PUT(HDRP(ptr), PACK(combine_size, 1));
+        PUT(FTRP(ptr), PACK(combine_size, 1));
+
+        return ptr;
+    }
+
+    newp = mm_malloc(size);
+    if (newp == NULL)
+    {
+        printf("ERROR: mm_malloc failed in mm_realloc\n");
+        exit(1);
+    }
+    copySize = GET_SIZE(HDRP(ptr));
+    if(size < copySize)
+    {
+        copySize = size;
+    }
+    memcpy(newp, ptr, copySize);
+    mm_free(ptr);
+    return newp;
+}
@@ -0,0 +1,530 @@
+/*
+ * sizeclass.c - Offline size-class analyzer for the Malloc Lab
+ *
+ * Replays the malloc and free requests of one or more trace files
+ * and writes a sizeclass.h header for mm.c to stdout. The header
+ * holds the rounding table mm_malloc applies to request sizes and
+ * the bin boundaries getbin sorts free blocks by.
+ *
+ * A request size s gets rounded up to a slightly larger size t when
+ * blocks of size s are freed and the holes they leave are then
+ * passed over by requests for t, which cannot fit in them. Serving
+ * s as t turns those holes into exact fits for the t requests.
+ *
+ * Past its exact bins mm.c has a bin per power of two, which leaves
+ * MAX_SPLITS bits of its 64-bit binmap free. Each of those bins is
+ * spent splitting a bin where the traces request many blocks on both
+ * sides of the cut, so sizes asked for together stop sharing a list.
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <getopt.h>
+
+/**********************
+ * Constants and macros
+ **********************/
+
+#define MAXLINE     1024 /* max string size */
+#define NCAND          4 /* round-up candidates tracked per size */
+#define BIN_MIN      256 /* smallest block mm.c bins by size range */
+#define BIN_TOP       31 /* log2 of the lower bound of its last bin */
+#define MAX_SPLITS     8 /* bins its binmap has room for past those */
+#define MAX_BOUNDS  (BIN_TOP - 8 + 1 + MAX_SPLITS)
+
+/* block mm.c carves for a request: a header word, 8-byte aligned */
+#define BLOCK(size) (((size) + 4 + 7) & ~7U)
+
+/* Defaults for the -m, -p and -r options */
+#define MIN_ALLOCS   100 /* rounded sizes are requested at least this often */
+#define MIN_SHARE     50 /* percent of those requests that miss a hole */
+#define MAX_ROUND     25 /* percent a size may be rounded up by */
+
+/*****************************
+ * The key compound data types
+ *****************************/
+
+/* One distinct malloc request size seen in the traces */
+typedef struct {
+    unsigned int size;              /* request size in bytes */
+    long allocs;                    /* number of mallocs of this size */
+    long holes;                     /* freed blocks not yet refilled */
+    unsigned int to;                /* size it rounds to, or 0 */
+    struct {
+        unsigned int size;          /* larger request that missed a hole */
+        long misses;                /* how many times it did */
+    } cand[NCAND];
+} class_t;
+
+/********************
+ * Global variables
+ *******************/
+
+static class_t *classes = NULL;     /* distinct sizes, in ascending order */
+static int num_classes = 0;
+static int max_classes = 0;
+static int max_round = MAX_ROUND;   /* percent a size may be rounded up by */
+static unsigned int bounds[MAX_BOUNDS]; /* bin lower bounds, ascending */
+static int num_bounds = 0;
+
+/*********************
+ * Function prototypes
+ *********************/
+
+static class_t *find_class(unsigned int size, int add);
+static FILE *open_trace(char *path, int *num_ids);
+static void scan_sizes(char *path);
+static void replay(char *path);
+static void miss(class_t *c, unsigned int size);
+static void decide(long min_allocs, int min_share);
+static void split_bins(long min_allocs);
+static void emit(int argc, char **argv, int first);
+static void usage(void);
+static void unix_error(const char *msg);
+static void app_error(const char *msg);
+
+/**************
+ * Main routine
+ **************/
+int main(int argc, char **argv)
+{
+    int i;
+    int c;
+    long min_allocs = MIN_ALLOCS;
+    int min_share = MIN_SHARE;
+
+    while ((c = getopt(argc, argv, "hm:p:r:")) != EOF) {
+        switch (c) {
+        case 'm':
+            min_allocs = atol(optarg);
+            break;
+        case 'p':
+            min_share = atoi(optarg);
+            break;
+        case 'r':
+            max_round = atoi(optarg);
+            break;
+        case 'h':
+            usage();
+            exit(0);
+        default:
+            usage();
+            exit(1);
+        }
+    }
+    if (optind == argc) {
+        usage();
+        exit(1);
+    }
+
+    /* Collect every request size first so lookups are a binary search */
+    for (i = optind; i < argc; i++)
+        scan_sizes(argv[i]);
+    for (i = optind; i < argc; i++)
+        replay(argv[i]);
+
+    decide(min_allocs, min_share);
+    split_bins(min_allocs);
+    emit(argc, argv, optind);
+    exit(0);
+}
+
+/*
+ * find_class - Look up the class of a request size, inserting it in
+ *     order if add is set and it is not there yet
+ */
+static class_t *find_class(unsigned int size, int add)
+{
+    int lo = 0, hi = num_classes;
+
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (classes[mid].size < size)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    if (lo < num_classes && classes[lo].size == size)
+        return &classes[lo];
+    if (!add)
+        return NULL;
+
+    if (num_classes == max_classes) {
+        max_classes = max_classes ? 2 * max_classes : 256;
+        if ((classes = realloc(classes, max_classes * sizeof(class_t))) == NULL)
+            unix_error("realloc failed in find_class");
+    }
+    memmove(&classes[lo + 1], &classes[lo],
+            (num_classes - lo) * sizeof(class_t));
+    memset(&classes[lo], 0, sizeof(class_t));
+    classes[lo].size = size;
+    num_classes++;
+    return &classes[lo];
+}
+
+/*
+ * open_trace - Open a trace file and read past its header, returning
+ *     the number of block ids it uses
+ */
+static FILE *open_trace(char *path, int *num_ids)
+{
+    FILE *tracefile;
+    int heapsize, num_ops, weight;
+    char msg[MAXLINE];
+
+    if ((tracefile = fopen(path, "r")) == NULL) {
+        sprintf(msg, "Could not open %s", path);
+        unix_error(msg);
+    }
+    if (4 != fscanf(tracefile, "%d %d %d %d",
+                    &heapsize, num_ids, &num_ops, &weight)) {
+        sprintf(msg, "Bad trace header in %s", path);
+        app_error(msg);
+    }
+    return tracefile;
+}
+
+/*
+ * scan_sizes - Add the size of every malloc request in a trace
+ */
+static void scan_sizes(char *path)
+{
+    FILE *tracefile;
+    char type[MAXLINE];
+    int num_ids;
+    unsigned int index, size, align, nmemb, count;
+
+    tracefile = open_trace(path, &num_ids);
+    while (fscanf(tracefile, "%s", type) != EOF) {
+        if (type[0] == 'f') {
+            if (1 != fscanf(tracefile, "%u", &index))
+                app_error("fscanf of free");
+            continue;
+        }
+        if (type[0] == 'F') {
+            if (1 != fscanf(tracefile, "%u", &count))
+                app_error("fscanf of batch free");
+            for (; count > 0; count--)
+                if (1 != fscanf(tracefile, "%u", &index))
+                    app_error("fscanf of batch free");
+            continue;
+        }
+        if (type[0] == 'm') {
+            if (3 != fscanf(tracefile, "%u %u %u", &index, &align, &size))
+                app_error("fscanf of memalign");
+            continue;
+        }
+        if (type[0] == 'c') {
+            if (3 != fscanf(tracefile, "%u %u %u", &index, &nmemb, &size))
+                app_error("fscanf of calloc");
+            find_class(nmemb * size, 1);
+            continue;
+        }
+        if (type[0] == 'b') {
+            if (3 != fscanf(tracefile, "%u %u %u", &index, &count, &size))
+                app_error("fscanf of batch malloc");
+            find_class(size, 1);
+            continue;
+        }
+        if (2 != fscanf(tracefile, "%u %u", &index, &size))
+            app_error("fscanf of allocation");
+        if (type[0] == 'a')
+            find_class(size, 1);
+    }
+    fclose(tracefile);
+}
+
+/*
+ * replay - Follow the holes each size leaves behind through a trace
+ *     and record which larger requests go past them unfilled
+ */
+static void replay(char *path)
+{
+    FILE *tracefile;
+    char type[MAXLINE];
+    char msg[MAXLINE];
+    int num_ids, i;
+    unsigned int index, size, align, nmemb, count, j;
+    class_t **blocks;
+    class_t *c;
+
+    tracefile = open_trace(path, &num_ids);
+    if ((blocks = calloc(num_ids, sizeof(class_t *))) == NULL)
+        unix_error("calloc failed in replay");
+    for (i = 0; i < num_classes; i++)
+        classes[i].holes = 0;
+
+    while (fscanf(tracefile, "%s", type) != EOF) {
+        switch (type[0]) {
+        case 'a':
+        case 'c':
+            /* a calloc is rounded like a malloc of the whole block */
+            if (type[0] == 'c') {
+                if (3 != fscanf(tracefile, "%u %u %u", &index, &nmemb, &size))
+                    app_error("fscanf of calloc");
+                size *= nmemb;
+            }
+            else if (2 != fscanf(tracefile, "%u %u", &index, &size))
+                app_error("fscanf of allocation");
+            if (index >= (unsigned int)num_ids)
+                app_error("block id out of range");
+            c = find_class(size, 0);
+            c->allocs++;
+            if (c->holes > 0)
+                c->holes--;
+            else
+                miss(c, size);
+            blocks[index] = c;
+            break;
+        case 'b':
+            /* count mallocs of size for ids index onwards */
+            if (3 != fscanf(tracefile, "%u %u %u", &index, &count, &size))
+                app_error("fscanf of batch malloc");
+            if (index >= (unsigned int)num_ids ||
+                count > (unsigned int)num_ids - index)
+                app_error("block id out of range");
+            c = find_class(size, 0);
+            for (j = index; j < index + count; j++) {
+                c->allocs++;
+                if (c->holes > 0)
+                    c->holes--;
+                else
+                    miss(c, size);
+                blocks[j] = c;
+            }
+            break;
+        case 'r':
+            /* realloc is never rounded, its block leaves no hole of interest */
+            if (2 != fscanf(tracefile, "%u %u", &index, &size))
+                app_error("fscanf of realloc");
+            if (index >= (unsigned int)num_ids)
+                app_error("block id out of range");
+            blocks[index] = NULL;
+            break;
+        case 'm':
+            /* aligned blocks are carved out exactly, never rounded */
+            if (3 != fscanf(tracefile, "%u %u %u", &index, &align, &size))
+                app_error("fscanf of memalign");
+            if (index >= (unsigned int)num_ids)
+                app_error("block id out of range");
+            blocks[index] = NULL;
+            break;
+        case 'f':
+            if (1 != fscanf(tracefile, "%u", &index))
+                app_error("fscanf of free");
+            if (index >= (unsigned int)num_ids)
+                app_error("block id out of range");
+            if (blocks[index] != NULL)
+                blocks[index]->holes++;
+            blocks[index] = NULL;
+            break;
+        case 'F':
+            /* a batch free leaves the same holes as its frees one by one */
+            if (1 != fscanf(tracefile, "%u", &count))
+                app_error("fscanf of batch free");
+            for (; count > 0; count--) {
+                if (1 != fscanf(tracefile, "%u", &index))
+                    app_error("fscanf of batch free");
+                if (index >= (unsigned int)num_ids)
+                    app_error("block id out of range");
+                if (blocks[index] != NULL)
+                    blocks[index]->holes++;
+                blocks[index] = NULL;
+            }
+            break;
+        default:
+            sprintf(msg, "Bogus type character (%c) in tracefile %s",
+                    type[0], path);
+            app_error(msg);
+        }
+    }
+    free(blocks);
+    fclose(tracefile);
+}
+
+/*
+ * miss - A request for size found no hole of its own size. Charge it
+ *     to the nearest smaller size with a hole waiting, had that size
+ *     been rounded up to this one the request would have fit there.
+ */
+static void miss(class_t *c, unsigned int size)
+{
+    class_t *s;
+    int i;
+
+    for (s = c - 1; s >= classes &&
+             (long)size * 100 <= (long)s->size * (100 + max_round); s--) {
+        if (s->holes == 0)
+            continue;
+        s->holes--;
+        for (i = 0; i < NCAND; i++) {
+            if (s->cand[i].size == size || s->cand[i].size == 0) {
+                s->cand[i].size = size;
+                s->cand[i].misses++;
+                break;
+            }
+        }
+        return;
+    }
+}
+
+/*
+ * decide - Round each size up to the larger size that missed its holes
+ *     most, if that happened often enough
+ */
+static void decide(long min_allocs, int min_share)
+{
+    int i, j;
+    long best;
+    class_t *c, *t;
+
+    for (i = 0; i < num_classes; i++) {
+        c = &classes[i];
+        if (c->allocs < min_allocs)
+            continue;
+        best = 0;
+        for (j = 0; j < NCAND && c->cand[j].size != 0; j++) {
+            if (c->cand[j].misses * 100 < c->allocs * min_share)
+                continue;
+            if (c->cand[j].misses > best) {
+                best = c->cand[j].misses;
+                c->to = c->cand[j].size;
+            }
+        }
+    }
+
+    /* A rule's target may itself be rounded, follow it to the end */
+    for (i = num_classes - 1; i >= 0; i--) {
+        c = &classes[i];
+        if (c->to != 0 && (t = find_class(c->to, 0))->to != 0)
+            c->to = t->to;
+    }
+}
+
+/*
+ * split_bins - Start from a bin per power of two and add MAX_SPLITS
+ *     more boundaries, each at the block size that leaves the most
+ *     requests on its thinner side, as long as that is at least
+ *     min_allocs. A rounded size counts as the size it is served as.
+ */
+static void split_bins(long min_allocs)
+{
+    long *weight;
+    long total, below, best;
+    unsigned int size, cut = 0;
+    int i, j, b, lo, hi;
+    class_t *t;
+
+    if ((weight = calloc(num_classes, sizeof(long))) == NULL)
+        unix_error("calloc failed in split_bins");
+    for (i = 0; i < num_classes; i++) {
+        t = classes[i].to != 0 ? find_class(classes[i].to, 0) : &classes[i];
+        weight[t - classes] += classes[i].allocs;
+    }
+    for (size = BIN_MIN; num_bounds < BIN_TOP - 8 + 1; size *= 2)
+        bounds[num_bounds++] = size;
+
+    while (num_bounds < MAX_BOUNDS) {
+        best = min_allocs - 1;
+        for (b = 0, lo = 0; b < num_bounds; b++, lo = hi) {
+            /* classes lo..hi-1 take blocks in bin b */
+            for (; lo < num_classes && BLOCK(classes[lo].size) < bounds[b]; lo++)
+                ;
+            for (hi = lo; hi < num_classes && (b + 1 == num_bounds ||
+                 BLOCK(classes[hi].size) < bounds[b + 1]); hi++)
+                ;
+            for (total = 0, j = lo; j < hi; j++)
+                total += weight[j];
+            for (below = 0, j = lo; j < hi; below += weight[j++]) {
+                size = BLOCK(classes[j].size);
+                if (j == lo || size == BLOCK(classes[j - 1].size))
+                    continue;
+                if (below > best && total - below > best) {
+                    best = below < total - below ? below : total - below;
+                    cut = size;
+                }
+            }
+        }
+        if (best < min_allocs)
+            break;
+        for (b = num_bounds; bounds[b - 1] > cut; b--)
+            bounds[b] = bounds[b - 1];
+        bounds[b] = cut;
+        num_bounds++;
+    }
+    free(weight);
+}
+
+/*
+ * emit - Write the header to stdout
+ */
+static void emit(int argc, char **argv, int first)
+{
+    int i, n = 0;
+
+    printf("/*\n");
+    printf(" * sizeclass.h - size-class table for mm.c, generated by sizeclass\n");
+    printf(" *     from:\n");
+    for (i = first; i < argc; i++)
+        printf(" *     %s\n", argv[i]);
+    printf(" */\n");
+    printf("#ifndef __SIZECLASS_H_\n");
+    printf("#define __SIZECLASS_H_\n\n");
+    printf("/* malloc requests of exactly from bytes are served as to bytes */\n");
+    printf("static const struct\n{\n    unsigned int from;\n    unsigned int to;\n");
+    printf("}size_rounds[] =\n{\n");
+    for (i = 0; i < num_classes; i++) {
+        if (classes[i].to != 0) {
+            printf("    {%u, %u},\n", classes[i].size, classes[i].to);
+            n++;
+        }
+    }
+    printf("    {0, 0}\n};\n");
+    printf("#define NROUNDS %d\n\n", n);
+    printf("/* lower bounds, in block bytes, of the bins past the exact ones */\n");
+    printf("static const unsigned int bin_bounds[] =\n{\n");
+    for (i = 0; i < num_bounds; i++)
+        printf("    %u,\n", bounds[i]);
+    printf("};\n");
+    printf("#define NBOUNDS %d\n\n", num_bounds);
+    printf("/* the bin_bounds entry of 1 << (i + 8), where walks in getbin start */\n");
+    printf("static const unsigned char bin_pow2[] =\n{\n   ");
+    for (i = 0; i < num_bounds; i++)
+        if ((bounds[i] & (bounds[i] - 1)) == 0)
+            printf(" %d,", i);
+    printf("\n};\n\n");
+    printf("#endif /* __SIZECLASS_H_ */\n");
+}
+
+/*
+ * usage - Explain the command line arguments
+ */
+static void usage(void)
+{
+    fprintf(stderr, "Usage: sizeclass [-h] [-m <n>] [-p <pct>] [-r <pct>] <trace>...\n");
+    fprintf(stderr, "Options\n");
+    fprintf(stderr, "\t-h         Print this message.\n");
+    fprintf(stderr, "\t-m <n>     Only round sizes requested at least n times (%d).\n", MIN_ALLOCS);
+    fprintf(stderr, "\t-p <pct>   ...of which pct percent miss a hole (%d).\n", MIN_SHARE);
+    fprintf(stderr, "\t-r <pct>   Round a size up by at most pct percent (%d).\n", MAX_ROUND);
+}
+
+/*
+ * unix_error - Report a Unix-style error
+ */
+static void unix_error(const char *msg)
+{
+    fprintf(stderr, "%s: %s\n", msg, strerror(errno));
+    exit(1);
+}
+
+/*
+ * app_error - Report an arbitrary application error
+ */
+static void app_error(const char *msg)
+{
+    fprintf(stderr, "%s\n", msg);
+    exit(1);
+}
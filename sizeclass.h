@@ -0,0 +1,83 @@
+/*
+ * sizeclass.h - size-class table for mm.c, generated by sizeclass
+ *     from:
+ *     traces/batch-bal.rep
+ *     traces/batchfree-bal.rep
+ *     traces/binary-bal.rep
+ *     traces/binary2-bal.rep
+ *     traces/calloc-bal.rep
+ *     traces/cccp-bal.rep
+ *     traces/coalescing-bal.rep
+ *     traces/cp-decl-bal.rep
+ *     traces/expr-bal.rep
+ *     traces/goodfit-bal.rep
+ *     traces/memalign-bal.rep
+ *     traces/random-bal.rep
+ *     traces/random2-bal.rep
+ *     traces/realloc-bal.rep
+ *     traces/realloc-tail-bal.rep
+ *     traces/realloc2-bal.rep
+ *     traces/short1-bal.rep
+ *     traces/short2-bal.rep
+ */
+#ifndef __SIZECLASS_H_
+#define __SIZECLASS_H_
+
+/* malloc requests of exactly from bytes are served as to bytes */
+static const struct
+{
+    unsigned int from;
+    unsigned int to;
+}size_rounds[] =
+{
+    {112, 128},
+    {448, 512},
+    {0, 0}
+};
+#define NROUNDS 2
+
+/* lower bounds, in block bytes, of the bins past the exact ones */
+static const unsigned int bin_bounds[] =
+{
+    256,
+    336,
+    408,
+    416,
+    512,
+    536,
+    1024,
+    1504,
+    1512,
+    2048,
+    2872,
+    3720,
+    4096,
+    8192,
+    16384,
+    32768,
+    65536,
+    131072,
+    262144,
+    524288,
+    1048576,
+    2097152,
+    4194304,
+    8388608,
+    16777216,
+    33554432,
+    67108864,
+    134217728,
+    268435456,
+    536870912,
+    1073741824,
+    2147483648,
+};
+#define NBOUNDS 32
+
+/* the bin_bounds entry of 1 << (i + 8), where walks in getbin start */
+static const unsigned char bin_pow2[] =
+{
+    0, 4, 6, 9, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31,
+};
+
+#endif /* __SIZECLASS_H_ */
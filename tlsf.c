@@ -0,0 +1,414 @@
+/*
+ * tlsf.c - Two-level segregated fit allocator.
+ *
+ * Uses the same boundary tag block format as mm.c (4 byte header
+ * and footer holding size | alloc). Free blocks are kept in a
+ * two-level array of doubly linked lists:
+ *
+ *   fl - first level, one row per power of two of the block size
+ *   sl - second level, each row split into SL_COUNT equal ranges
+ *
+ * fl_bitmap has bit fl set iff row fl has any non-empty list, and
+ * sl_bitmap[fl] has bit sl set iff lists[fl][sl] is non-empty.
+ * Sizes below SMALL_BLOCK all map to row 0 in SL_COUNT linear steps.
+ *
+ * malloc rounds the request up to the next list boundary so that
+ * any block in the chosen list fits, and finds that list with two
+ * find-first-set operations. free coalesces with both neighbours
+ * through the boundary tags. Neither walks a list, so both are O(1).
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <memory.h>
+#include "mm.h"
+#include "memlib.h"
+
+team_t team = {
+    "The BOI",
+    "Vincent Liu",
+    "vili1624@colorado.edu",
+    "Christian Sousa",
+    "chso8299@colorado.edu"
+};
+
+#define WSIZE       4
+#define DSIZE       8
+#define CHUNKSIZE  (1<<8)
+#define OVERHEAD    8
+#define MINIMUM     24
+
+#define SL_LOG2     4
+#define SL_COUNT    (1 << SL_LOG2)
+#define FL_SHIFT    8
+#define SMALL_BLOCK (1 << FL_SHIFT)
+#define FL_COUNT    (32 - FL_SHIFT + 1)
+
+static inline int MAX(int x, int y)
+{
+    return x > y ? x : y;
+}
+
+static inline uint32_t PACK(uint32_t size, int alloc)
+{
+    return ((size) | (alloc & 0x1));
+}
+
+static inline uint32_t GET(void *p)
+{
+    return  *(uint32_t *)p;
+}
+
+static inline void PUT( void *p, uint32_t val)
+{
+    *((uint32_t *)p) = val;
+}
+
+static inline uint32_t GET_SIZE(void *p)
+{
+    return GET(p) & ~0x7;
+}
+
+static inline int GET_ALLOC(void *p)
+{
+    return GET(p) & 0x1;
+}
+
+static inline void *HDRP(void *bp)
+{
+    return ( (char *)bp) - WSIZE;
+}
+
+static inline void *FTRP(void *bp)
+{
+    return ((char *)(bp) + GET_SIZE(HDRP(bp)) - DSIZE);
+}
+
+static inline void *NEXT_BLKP(void *bp)
+{
+    return  ((char *)(bp) + GET_SIZE(((char *)(bp) - WSIZE)));
+}
+
+static inline void* PREV_BLKP(void *bp)
+{
+    return  ((char *)(bp) - GET_SIZE(((char *)(bp) - DSIZE)));
+}
+
+typedef struct freelist
+{
+    struct freelist *prev;
+    struct freelist *next;
+}freelist;
+
+static freelist *lists[FL_COUNT][SL_COUNT];
+static uint32_t fl_bitmap;
+static uint32_t sl_bitmap[FL_COUNT];
+
+static void *extend_heap(uint32_t words);
+static void insert_to_free(freelist *bp);
+static void remove_from_free(freelist* bp);
+static void *find_fit(uint32_t asize);
+static void place(void *bp, uint32_t asize);
+static void *coalesce(void *bp);
+
+static inline int fls(uint32_t x)
+{
+    return 31 - __builtin_clz(x);
+}
+
+/*
+ * mapping - the list a block of this size belongs in
+ */
+static inline void mapping(uint32_t size, int *fl, int *sl)
+{
+    if(size < SMALL_BLOCK)
+    {
+        *fl = 0;
+        *sl = size / (SMALL_BLOCK / SL_COUNT);
+    }
+    else
+    {
+        int f = fls(size);
+        *sl = (size >> (f - SL_LOG2)) ^ SL_COUNT;
+        *fl = f - FL_SHIFT + 1;
+    }
+}
+
+/*
+ * mapping_search - the first list whose blocks are all >= size
+ */
+static inline void mapping_search(uint32_t size, int *fl, int *sl)
+{
+    if(size >= SMALL_BLOCK)
+    {
+        size += (1 << (fls(size) - SL_LOG2)) - 1;
+    }
+    else
+    {
+        size += (SMALL_BLOCK / SL_COUNT) - 1;
+    }
+    mapping(size, fl, sl);
+}
+
+int mm_init(void)
+{
+    void *start;
+
+    memset(lists, 0, sizeof(lists));
+    memset(sl_bitmap, 0, sizeof(sl_bitmap));
+    fl_bitmap = 0;
+
+    if((start = mem_sbrk(4*WSIZE)) == (void*) -1)
+        return -1;
+
+    PUT(start, 0);
+    PUT(start + (WSIZE), PACK(DSIZE, 1));
+    PUT(start + (2*WSIZE), PACK(DSIZE, 1));
+    PUT(start + (3*WSIZE), PACK(0,1));
+
+    if(extend_heap(CHUNKSIZE/WSIZE) == NULL)
+        return -1;
+
+    return 0;
+}
+
+static void *extend_heap(uint32_t words)
+{
+    void *bp;
+    uint32_t size;
+    size = (words%2) ? (words+1) * WSIZE : words * WSIZE;
+    if((bp = mem_sbrk(size)) == (void*) -1)
+        return NULL;
+
+    PUT(HDRP(bp), PACK(size, 0));
+    PUT(FTRP(bp), PACK(size, 0));
+    PUT(HDRP(NEXT_BLKP(bp)), PACK(0,1));
+
+    return coalesce(bp);
+}
+
+void *mm_malloc(size_t size)
+{
+    uint32_t asize;
+    uint32_t extendsize;
+    void *bp;
+
+    if(size == 0 || size > UINT32_MAX / 2)
+    {
+        return NULL;
+    }
+    else if(size <= DSIZE)
+    {
+        size = 2*DSIZE;
+    }
+    else if((size%DSIZE) != 0)
+    {
+        uint32_t times = size/DSIZE;
+        size = (times+1)* DSIZE;
+    }
+    asize = size + DSIZE;
+    if((bp = find_fit(asize)) != NULL)
+    {
+        place(bp, asize);
+        return bp;
+    }
+
+    extendsize = MAX(asize, CHUNKSIZE);
+    if((bp = extend_heap(extendsize/WSIZE)) == NULL)
+        return NULL;
+
+    place(bp, asize);
+    return bp;
+}
+
+static void *find_fit(uint32_t asize)
+{
+    int fl, sl;
+    uint32_t map;
+    freelist *bp;
+
+    /*
+     * The list asize itself maps to may hold a block that fits even
+     * though not all of them do; checking its head stays O(1) and
+     * keeps exact-size reuse from falling through to a bigger list.
+     */
+    mapping(asize, &fl, &sl);
+    bp = lists[fl][sl];
+    if(bp != NULL && GET_SIZE(HDRP(bp)) >= asize)
+    {
+        return bp;
+    }
+
+    mapping_search(asize, &fl, &sl);
+    if(fl >= FL_COUNT)
+    {
+        return NULL;
+    }
+
+    map = sl_bitmap[fl] & (~0U << sl);
+    if(map == 0)
+    {
+        if(fl + 1 >= FL_COUNT)
+        {
+            return NULL;
+        }
+        map = fl_bitmap & (~0U << (fl + 1));
+        if(map == 0)
+        {
+            return NULL;
+        }
+        fl = __builtin_ctz(map);
+        map = sl_bitmap[fl];
+    }
+    sl = __builtin_ctz(map);
+    return lists[fl][sl];
+}
+
+static void place(void *bp, uint32_t asize)
+{
+    uint32_t csize = GET_SIZE(HDRP(bp));
+
+    remove_from_free((freelist*)bp);
+    if((csize - asize) >= MINIMUM)
+    {
+        PUT(HDRP(bp), PACK(asize, 1));
+        PUT(FTRP(bp), PACK(asize, 1));
+
+        bp = NEXT_BLKP(bp);
+        PUT(HDRP(bp), PACK(csize - asize, 0));
+        PUT(FTRP(bp), PACK(csize - asize, 0));
+        insert_to_free((freelist*)bp);
+    }
+    else
+    {
+        PUT(HDRP(bp), PACK(csize, 1));
+        PUT(FTRP(bp), PACK(csize, 1));
+    }
+}
+
+static void remove_from_free(freelist* bp)
+{
+    int fl, sl;
+
+    mapping(GET_SIZE(HDRP(bp)), &fl, &sl);
+    if(bp->prev == NULL)
+    {
+        lists[fl][sl] = bp->next;
+        if(lists[fl][sl] == NULL)
+        {
+            sl_bitmap[fl] &= ~(1U << sl);
+            if(sl_bitmap[fl] == 0)
+            {
+                fl_bitmap &= ~(1U << fl);
+            }
+        }
+    }
+    else
+    {
+        bp->prev->next = bp->next;
+    }
+    if(bp->next != NULL)
+    {
+        bp->next->prev = bp->prev;
+    }
+}
+
+static void insert_to_free(freelist *bp)
+{
+    int fl, sl;
+
+    mapping(GET_SIZE(HDRP(bp)), &fl, &sl);
+    bp->prev = NULL;
+    bp->next = lists[fl][sl];
+    if(lists[fl][sl] != NULL)
+    {
+        lists[fl][sl]->prev = bp;
+    }
+    lists[fl][sl] = bp;
+    sl_bitmap[fl] |= 1U << sl;
+    fl_bitmap |= 1U << fl;
+}
+
+void mm_free(void *bp)
+{
+    if(bp == 0)
+        return;
+
+    uint32_t size = GET_SIZE(HDRP(bp));
+
+    PUT(HDRP(bp), PACK(size, 0));
+    PUT(FTRP(bp), PACK(size, 0));
+
+    coalesce(bp);
+}
+
+static void *coalesce(void *bp)
+{
+    size_t prev_alloc = GET_ALLOC(FTRP(PREV_BLKP(bp)));
+    size_t next_alloc = GET_ALLOC(HDRP(NEXT_BLKP(bp)));
+    size_t size = GET_SIZE(HDRP(bp));
+
+    if(!next_alloc)
+    {
+        size = size + GET_SIZE(HDRP(NEXT_BLKP(bp)));
+        remove_from_free((freelist*)NEXT_BLKP(bp));
+    }
+    if(!prev_alloc)
+    {
+        size = size + GET_SIZE(HDRP(PREV_BLKP(bp)));
+        remove_from_free((freelist*)PREV_BLKP(bp));
+        bp = PREV_BLKP(bp);
+    }
+    PUT(HDRP(bp), PACK(size, 0));
+    PUT(FTRP(bp), PACK(size, 0));
+    insert_to_free((freelist*)bp);
+    return bp;
+}
+
+void *mm_realloc(void *ptr, size_t size)
+{
+    void *newp;
+    uint32_t copySize;
+
+    if(size > UINT32_MAX / 2)
+    {
+        return NULL;
+    }
+
+    uint32_t next_alloc = GET_ALLOC(HDRP(NEXT_BLKP(ptr)));
+
+    uint32_t next_size = GET_SIZE(HDRP(NEXT_BLKP(ptr)));
+
+    uint32_t curr_size = GET_SIZE(HDRP(ptr));
+    uint32_t combine_size = curr_size + next_size;
+    uint32_t asize = size + DSIZE;
+
+    if(curr_size > asize)
+    {
+        return ptr;
+    }
+
+    if(!next_alloc && combine_size >= asize)
+    {
+        remove_from_free((freelist*)NEXT_BLKP(ptr));
+        PUT(HDRP(ptr), PACK(combine_size, 1));
+        PUT(FTRP(ptr), PACK(combine_size, 1));
+
+        return ptr;
+    }
+
+    newp = mm_malloc(size);
+    if (newp == NULL)
+    {
+        printf("ERROR: mm_malloc failed in mm_realloc\n");
+        exit(1);
+    }
+    copySize = GET_SIZE(HDRP(ptr));
+    if(size < copySize)
+    {
+        copySize = size;
+    }
+    memcpy(newp, ptr, copySize);
+    mm_free(ptr);
+    return newp;
+}